@@ -20,6 +20,15 @@
 #ifndef _ANIMATION_
 #include "animation.hpp"
 #endif
+#ifndef _TEXTUREBAKE_
+#include "texture_bake.hpp"
+#endif
+#ifndef _PRELOADER_
+#include "preloader.hpp"
+#endif
+#ifndef _SPRITESHEET_
+#include "sprite_sheet.hpp"
+#endif
 #ifndef _Time_string_
 #include "Time_string.hpp"
 #endif
@@ -52,15 +61,8 @@ private :
 
 	//! Wymon animation.
 	animation m_wymon;
-	//! Clock for the Animation
+	//! Time since the last animation::update() of m_wymon.
 	sf::Clock m_clock;
-	//! Elapsed time since last frame.
-	/*!
-	* This variable stores the time that has been passed since the last time
-	* the animation rendered a frame. If this hits a limit, the animation
-	* should render again.
-	*/
-	sf::Time m_elap_time;
 
 	//! Font used for all text inside the window.
 	sf::Font m_font;
@@ -76,6 +78,7 @@ private :
 	Textfield m_textfield ;
 
 	void obj_pos();
+	void fit_bg();
 	void render();
 
 public :
@@ -85,6 +88,7 @@ public :
 	~Orion();
 
 	bool win_icon(const std::string& filename);
+	void win_icon(const sf::Image& icon);
 
 	void proc_events();
 	void draw_obj() ;
@@ -5,6 +5,7 @@
 #define _ANIMATION_
 
 #include <SFML/Graphics.hpp>
+#include <vector>
 #ifndef _TEXTUREABLE_
 #include "texturable.hpp"
 #endif
@@ -20,6 +21,9 @@
 * This class provides methods for creating, modifying and rendering animated
 * sprites. It uses a texture as base for the graphical information and frames,
 * which provide basic information about animation frames.
+*
+* Frames are either stepped through with render(), or played by time with
+* update(), which uses the duration of each frame.
 */
 class animation : public Textureable {
 
@@ -30,16 +34,24 @@ public:
     animation();
     animation(const sf::Texture& texture);
     animation(const sf::Texture& texture, const sf::IntRect& rect);
+    animation(const animation& other);
     ~animation();
 
+    animation& operator=(const animation& other);
+
     std::size_t insert(const frame& frm, sf::IntRect rect = sf::IntRect());
     std::size_t insert(const frame& frm, std::size_t index,
                        sf::IntRect rect = sf::IntRect());
+    std::size_t insert(const std::vector<frame>& frms, std::size_t index,
+                       sf::IntRect rect = sf::IntRect());
     std::size_t insert(const frame_group& frm_grp,
                        sf::IntRect rect = sf::IntRect());
     std::size_t insert(const frame_group& frm_grp, std::size_t index,
                        sf::IntRect rect = sf::IntRect());
 
+    template <typename table>
+    void bind();
+
     void setTexRect(const sf::IntRect& rect);
 
 	void replace(std::size_t index, const frame& other);
@@ -49,6 +61,12 @@ public:
     std::size_t render();
     std::size_t render(std::size_t index);
 
+	void frame_time(sf::Time time);
+	sf::Time frame_time() const;
+	void durations(const std::vector<sf::Time>& times, std::size_t index = 0);
+	std::size_t update(sf::Time dt);
+	sf::Time next_deadline() const;
+
 	sf::FloatRect loc_bound() const;
 	sf::Vector2f max_obj_size();
 	sf::Vector2f max_size();
@@ -56,18 +74,43 @@ public:
 
 private:
 
+	void bind(frames_handle frames, const sf::IntRect& rect,
+			  const sf::Vector2f& max_size);
 	void calc_max_size(const sf::Vector2f& size);
+	static std::vector<frame> split(const frame_group& frm_grp);
+	sf::Time shown_for(std::size_t index) const;
+    void show_frame();
     void updateTexCoords();
 
     void draw(sf::RenderTarget& target, sf::RenderStates states) const;
 
-    //! Pointer to stored frames inside repository.
-    frames_ptr m_frames;
+    //! Handle of the stored frames inside repository.
+    frames_handle m_frames;
     //! Index of the current pointer.
     std::size_t m_index;
 	//! Biggest frame of the animation.
 	sf::Vector2f m_max_size;
+	//! Duration of frames without an own duration.
+	sf::Time m_frame_time;
+	//! Time the current frame has been shown, see update().
+	sf::Time m_elapsed;
 
 };
 
+//! Bind the animation to a frame table.
+/*!
+* Replaces the frames of the animation with the frames of the table, see
+* frame_table. The animation shares the frames stored for the table and takes
+* over its texture rectangle, so nothing is calculated.
+* \tparam table Instance of the frame_table template.
+*/
+template <typename table>
+void animation::bind() {
+
+	bind(table::handle(), table::tex_rect(),
+		 sf::Vector2f(static_cast<float>(table::width),
+					  static_cast<float>(table::height)));
+
+}
+
 #endif // _ANIMATION_
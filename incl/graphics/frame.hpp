@@ -7,11 +7,19 @@
 
 #include <SFML/Graphics.hpp>
 #include <utility>
+#include <cstdlib>
 
 //! Single animation frame.
 /*!
 * This class represents a single animation frame, defined by a position on the
 * texture and its size.
+*
+* A frame may be trimmed to the opaque part of its image, see
+* image_proc::trim(). Then it is only a part of the logical frame, which keeps
+* the size of the untrimmed one, so the animation does not change its size
+* from frame to frame. The offset places the trimmed part inside the logical
+* frame. Untrimmed frames have no offset and a logical size of zero, which
+* means the size of the frame itself.
 */
 class frame {
 
@@ -27,11 +35,19 @@ public:
     int w;
     //! Height of frame.
     int h;
+    //! Left offset inside the logical frame.
+    int ox;
+    //! Top offset inside the logical frame.
+    int oy;
+    //! Width of the logical frame, zero for the width of the frame.
+    int lw;
+    //! Height of the logical frame, zero for the height of the frame.
+    int lh;
 
     // Member functions.
 
     //! Default constructor.
-    frame() : x(0), y(0), w(0), h(0) {
+    frame() : x(0), y(0), w(0), h(0), ox(0), oy(0), lw(0), lh(0) {
     }
 
     //! Value constructor.
@@ -43,7 +59,24 @@ public:
     * \param height Height of frame.
     */
     frame(int x, int y, int width, int height) : x(x), y(y),
-          w(width), h(height) {
+          w(width), h(height), ox(0), oy(0), lw(0), lh(0) {
+    }
+
+    //! Trimmed frame constructor.
+    /*!
+    * Initializes a frame which is a part of a bigger logical frame.
+    * \param x X-coordinate, left offset.
+    * \param y Y-coordinate, top offset.
+    * \param width Width of frame.
+    * \param height Height of frame.
+    * \param off_x Left offset inside the logical frame.
+    * \param off_y Top offset inside the logical frame.
+    * \param log_width Width of the logical frame.
+    * \param log_height Height of the logical frame.
+    */
+    frame(int x, int y, int width, int height, int off_x, int off_y,
+          int log_width, int log_height) : x(x), y(y), w(width), h(height),
+          ox(off_x), oy(off_y), lw(log_width), lh(log_height) {
     }
 
     //! Value pair constructor.
@@ -53,7 +86,7 @@ public:
     * \param size Size of frame.
     */
     frame(sf::Vector2i pos, sf::Vector2i size) : x(pos.x), y(pos.y),
-          w(size.x), h(size.y) {
+          w(size.x), h(size.y), ox(0), oy(0), lw(0), lh(0) {
     }
 
     //! Copy constructor.
@@ -61,7 +94,8 @@ public:
     * Copy constructs frame from other frame.
     * \param other Frame from which to copy construct.
     */
-    frame(const frame& other) : x(other.x), y(other.y), w(other.w), h(other.h) {
+    frame(const frame& other) : x(other.x), y(other.y), w(other.w), h(other.h),
+          ox(other.ox), oy(other.oy), lw(other.lw), lh(other.lh) {
     }
 
     //! Move constructor.
@@ -70,7 +104,9 @@ public:
     * \param other Frame from which to move construct.
     */
     frame(frame&& other) : x(std::move(other.x)), y(std::move(other.y)),
-          w(std::move(other.w)), h(std::move(other.h)) {
+          w(std::move(other.w)), h(std::move(other.h)),
+          ox(std::move(other.ox)), oy(std::move(other.oy)),
+          lw(std::move(other.lw)), lh(std::move(other.lh)) {
     }
 
     //! Default destructor.
@@ -84,6 +120,56 @@ public:
         this->y = other.y;
         this->w = other.w;
         this->h = other.h;
+        this->ox = other.ox;
+        this->oy = other.oy;
+        this->lw = other.lw;
+        this->lh = other.lh;
+
+    }
+
+    //! Equality comparison.
+    /*!
+    * \param other Frame to compare with.
+    * \return True if position, size, offset and logical size of both frames
+    * are the same.
+    */
+    bool operator==(const frame& other) const {
+
+        return x == other.x && y == other.y && w == other.w && h == other.h &&
+               ox == other.ox && oy == other.oy && lw == other.lw &&
+               lh == other.lh;
+
+    }
+
+    //! Inequality comparison.
+    /*!
+    * \param other Frame to compare with.
+    * \return True if position or size of the frames differ.
+    */
+    bool operator!=(const frame& other) const {
+
+        return !(*this == other);
+
+    }
+
+    //! Size of the logical frame.
+    /*!
+    * \return Size the frame takes up when drawn, including the transparent
+    * border which has been trimmed.
+    */
+    sf::Vector2i logical_size() const {
+
+        return sf::Vector2i(lw ? lw : std::abs(w), lh ? lh : std::abs(h));
+
+    }
+
+    //! Check whether the frame is part of a bigger logical frame.
+    /*!
+    * \return True if the frame has an offset or a logical size.
+    */
+    bool trimmed() const {
+
+        return 0 != ox || 0 != oy || 0 != lw || 0 != lh;
 
     }
 
@@ -0,0 +1,164 @@
+// frame_pool - Pooled memory for the frame storage.
+// pool_allocator - Allocator handing out memory of the frame_pool.
+// frame_pool.hpp
+
+#ifndef _FRAMEPOOL_
+#define _FRAMEPOOL_
+
+#include <vector>
+#include <cstddef>
+#include <limits>
+#include <new>
+
+//! Static class handing out memory blocks for the frame storage.
+/*!
+* Every animation needs a dozen arrays for its frames, see frame_repository,
+* so many short-lived animations keep the system allocator busy. The pool
+* rounds each request up to a power of two between 32 bytes and 64 KiB, its
+* size class. Blocks of a class are cut out of 64 KiB slabs, and given back
+* blocks are kept on a free list of their class. Once the pool is warmed up,
+* creating and releasing animations does not call the system allocator
+* anymore. Bigger blocks are requested from the system allocator directly.
+*
+* Slabs are never given back, their blocks are only reused for the same size
+* class. Since the pool holds no objects with a destructor, blocks may still
+* be given back while static objects are destroyed.
+*
+* ATTENTION: Not thread safe, like the frame_repository which uses it.
+*/
+class frame_pool {
+
+public :
+
+	// Member types
+
+	//! Allocation counters.
+	struct statistics {
+
+		//! Number of blocks requested from the pool.
+		std::size_t requests;
+		//! Number of calls to the system allocator, for slabs and big blocks.
+		std::size_t system;
+		//! Bytes of all slabs.
+		std::size_t slab_bytes;
+		//! Bytes of all blocks in use, rounded up to their size class.
+		std::size_t in_use;
+
+	};
+
+	// Member functions
+
+	static void* allocate(std::size_t bytes);
+	static void deallocate(void* block, std::size_t bytes);
+
+	static statistics stats();
+	static std::size_t requests();
+
+private :
+
+	// Member functions
+
+	static std::size_t size_class(std::size_t bytes);
+	static void refill(std::size_t block_class);
+
+	// Member variables
+
+	//! Size of the smallest size class.
+	static const std::size_t min_block = 32;
+	//! Number of size classes.
+	static const std::size_t classes = 12;
+	//! Size of a slab, the size of the biggest size class.
+	static const std::size_t slab_size = min_block << (classes - 1);
+
+	static void* m_free[classes];
+	static statistics m_stats;
+
+};
+
+//! Allocator handing out memory of the frame_pool.
+/*!
+* Stateless, so all instances are equal and containers using it can exchange
+* their memory.
+*/
+template <typename T>
+class pool_allocator {
+
+public :
+
+	// Member types
+
+	//! Type of the allocated objects.
+	typedef T value_type;
+
+	// Member functions
+
+	//! Default constructor.
+	pool_allocator() {
+	}
+
+	//! Converting constructor.
+	/*!
+	* Used by containers which allocate other types, e.g. the nodes of a hash
+	* table.
+	*/
+	template <typename U>
+	pool_allocator(const pool_allocator<U>&) {
+	}
+
+	//! Allocate memory for objects.
+	/*!
+	* \param count Number of objects.
+	* \return Uninitialized memory for the objects.
+	*/
+	T* allocate(std::size_t count) {
+
+		if (std::numeric_limits<std::size_t>::max() / sizeof(T) < count) {
+
+			throw std::bad_alloc();
+
+		}
+
+		return static_cast<T*>(frame_pool::allocate(count * sizeof(T)));
+
+	}
+
+	//! Give back memory of objects.
+	/*!
+	* \param objects Memory returned by allocate().
+	* \param count Number of objects, as passed to allocate().
+	*/
+	void deallocate(T* objects, std::size_t count) {
+
+		frame_pool::deallocate(objects, count * sizeof(T));
+
+	}
+
+	//! Equality comparison.
+	/*!
+	* \return Always true, memory of one instance may be given back to any.
+	*/
+	template <typename U>
+	bool operator==(const pool_allocator<U>&) const {
+
+		return true;
+
+	}
+
+	//! Inequality comparison.
+	/*!
+	* \return Always false.
+	*/
+	template <typename U>
+	bool operator!=(const pool_allocator<U>&) const {
+
+		return false;
+
+	}
+
+};
+
+//! Vector whose memory comes from the frame_pool.
+template <typename T>
+using pool_vector = std::vector<T, pool_allocator<T>>;
+
+#endif // _FRAMEPOOL_
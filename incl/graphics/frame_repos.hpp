@@ -7,13 +7,16 @@
 
 #include <SFML/Graphics.hpp>
 #include <string>
-#include <list>
 #include <vector>
 #include <array>
-#include <memory>
+#include <cstdint>
+#include <unordered_map>
 #ifndef _FRAME_
 #include "frame.hpp"
 #endif
+#ifndef _FRAMEPOOL_
+#include "frame_pool.hpp"
+#endif
 
 //! Index for original frames.
 /*!
@@ -27,31 +30,96 @@ const std::size_t ORIG_FRM = 0;
 */
 const std::size_t TEX_RECT_FRM = 1;
 
-//! Type to simplify the storage of frames.
+//! Handle of frames stored inside the frame_repository.
 /*!
-* This type uses the ability of std::shared_ptr to count the number of
-* references currently in use. If only the frame container refers to the
-* frame, it will be deleted out of the memory.
-
-* This typedef is used to conveniently handle random access frame containers,
-* of which two exist. One for the plain frames of a animation, the other is used
-* for the frames with the applied texture rectangles for the visual part of the
-* frame. Both need to be kept alive, since the second one is obviously used for
-* the animation display and the first may be used if later on the texture
-* rectangle changes. The shared pointer makes sure the containers are shareable
-* and get destroyed once no animation uses them anymore. This also means the
-* frames inside the containers have to be always copied, so no access of
-* corrupted data occures.
+* An animation does not own its frames, it only holds a handle to the storage
+* inside the frame_repository. The lower 32 bits of the handle are the index of
+* the slot holding the frames, the upper 32 bits the generation of the slot.
+* Each time a slot is released, its generation is increased, so an outdated
+* handle never refers to the frames which have been stored in the slot later
+* on, see frame_repository::valid().
+*/
+typedef std::uint64_t frames_handle;
+
+//! Handle which does not refer to any frames.
+const frames_handle NO_FRM = 0;
+
+//! Random access container of frames, stored as structure of arrays.
+/*!
+* Instead of a vector of frames, the x-coordinates, y-coordinates, widths and
+* heights of the frames are stored in four separate vectors of the same size.
+* Functions working on all frames, like applying a texture rectangle, then run
+* over contiguous arrays of the same value, which lets them work on several
+* frames at once, see frame_repository::apply_tex_rect().
 *
-* Reason why these types are used:
-* std::list - Later used as frames_ptr container, allowes fast element insertion
-* and removal.
-* std::shared_ptr - sharing and use_count() of objects
-* std::array - fast for a fixed amount of elements; perfect since we allways
-* need two.
-* std::vector - random access, so the order of appearance can be abitrary.
+* Single frames are read by value with operator[](). They are written with
+* set(), or directly through the vectors. The memory of the vectors comes
+* from the frame_pool.
+*/
+class frame_set {
+
+public :
+
+	// Member variables
+
+	//! X-coordinates of the frames.
+	pool_vector<int> x;
+	//! Y-coordinates of the frames.
+	pool_vector<int> y;
+	//! Widths of the frames.
+	pool_vector<int> w;
+	//! Heights of the frames.
+	pool_vector<int> h;
+	//! Left offsets inside the logical frames.
+	pool_vector<int> ox;
+	//! Top offsets inside the logical frames.
+	pool_vector<int> oy;
+	//! Widths of the logical frames.
+	pool_vector<int> lw;
+	//! Heights of the logical frames.
+	pool_vector<int> lh;
+
+	// Member functions
+
+	frame operator[](std::size_t index) const;
+	void set(std::size_t index, const frame& frm);
+
+	std::size_t size() const;
+	bool empty() const;
+
+	void push_back(const frame& frm);
+	void insert(std::size_t index, const frame* frms, std::size_t count);
+	void clear();
+
+	bool operator==(const frame_set& other) const;
+
+};
+
+//! Ready to draw quad of a frame.
+/*!
+* Positions and texture coordinates of the four vertices an animation draws
+* for a frame with the applied texture rectangle, defined anticlockwise from
+* the top left corner. The texture coordinates are relative to the area of the
+* texture holding the image, see Textureable::m_tex_area. Takes up 64 bytes.
+*/
+struct frame_quad {
+
+	//! Positions of the vertices.
+	sf::Vector2f position[4];
+	//! Texture coordinates of the vertices.
+	sf::Vector2f tex_coords[4];
+
+};
+
+//! Type of the frames stored for a handle.
+/*!
+* Two random access frame containers exist for each handle. One for the plain
+* frames of an animation (ORIG_FRM), the other for the frames with the applied
+* texture rectangles for the visual part of the frame (TEX_RECT_FRM). Both need
+* to be kept, since the second one is used for the animation display and the
+* first may be used if later on the texture rectangle changes.
 */
-typedef std::shared_ptr<std::array<std::vector<frame>, 2>> frames_ptr;
+typedef std::array<frame_set, 2> frame_storage;
 
 //! Static class to automatically handle animation frames.
 /*!
@@ -61,42 +129,187 @@ typedef std::shared_ptr<std::array<std::vector<frame>, 2>> frames_ptr;
 * terms of memory. This is a drawback for function calls with animation object
 * parameters. To prevent this from happening, the frame objects are stored
 * outside the animation objects, inside this static class. So the size of an
-* animation instance will always be the same, holding only a pointer to the
-* random access frame container.
+* animation instance will always be the same, holding only a handle to the
+* random access frame containers.
+*
+* The frames are stored inside contiguous slots. Released slots are kept on a
+* free list and reused by the next create(), so creating and releasing frames
+* takes constant time and needs no walk over all frames. Each slot counts the
+* handles referring to it, with a plain counter instead of an atomic one.
+*
+* Identical frames are stored only once. Once the frames of a handle are
+* complete, intern() looks them up by the hash of their content and, if the
+* same frames are already stored for another handle, lets the handle share
+* them. E.g. a hundred instances of the same animation end up with a single
+* copy of their frames. Shared frames are copied on write: edit(), and every
+* function changing frames, first gives the handle its own copy if the frames
+* are shared, so the other animations do not see the change.
+*
+* The texture rectangle is applied lazily. Setting it with apply_tex_rect()
+* takes constant time, each frame is clipped on its first access afterwards,
+* see clipped(). Frames which are never shown are never clipped.
+*
+* Each frame also has a duration, the time an animation playing it shows the
+* frame, see animation::update().
+*
+* All arrays of the frames and the nodes of the intern table are allocated
+* from the frame_pool. Released slots keep their arrays for the next create(),
+* so an animation replacing a released one usually allocates nothing at all.
+* alloc_stats() counts the allocations per lifetime of the frames.
+*
+* ATTENTION: Not thread safe, only use it from the thread which handles the
+* animations, usually the render thread. References returned by get() and
+* edit() are invalidated by the next create().
 */
 class frame_repository {
 
 public :
 
+	// Member types
+
+	//! Allocation counters of the frame storage.
+	struct alloc_statistics {
+
+		//! Counters of the frame_pool holding the frames.
+		frame_pool::statistics pool;
+		//! Number of released frames.
+		std::size_t lifetimes;
+		//! Number of blocks requested for the released frames, during their
+		//! whole lifetime.
+		std::size_t lifetime_allocations;
+
+	};
+
 	// Member functions
 
-	static void create(frames_ptr* frm_ptr);
+	static void create(frames_handle* handle);
+	static void acquire(frames_handle handle);
+	static void release(frames_handle* handle);
+	static bool valid(frames_handle handle);
+
+	static const frame_storage& get(frames_handle handle);
+	static frame_storage& edit(frames_handle* handle);
+	static void intern(frames_handle* handle);
+	static bool shared(frames_handle handle);
 
-    static std::size_t insert(frames_ptr* frm_ptr, const frame& frm,
+	static std::size_t size(frames_handle handle);
+	static frame original(frames_handle handle, std::size_t index);
+	static frame clipped(frames_handle handle, std::size_t index);
+	static const frame_quad& quad(frames_handle handle, std::size_t index);
+
+    static std::size_t insert(frames_handle* handle, const frame& frm,
                               const sf::IntRect& tex_rect = sf::IntRect());
-	static std::size_t insert(frames_ptr* frm_ptr, const frame& frm,
+	static std::size_t insert(frames_handle* handle, const frame& frm,
                               std::size_t index,
                               const sf::IntRect& tex_rect = sf::IntRect());
+	static std::size_t insert(frames_handle* handle, const frame* frms,
+                              std::size_t count, std::size_t index,
+                              const sf::IntRect& tex_rect = sf::IntRect());
+	static std::size_t insert(frames_handle* handle, const frame* frms,
+							  const frame* clipped, std::size_t count,
+							  std::size_t index);
+
+	static sf::Time duration(frames_handle handle, std::size_t index);
+	static void set_durations(frames_handle* handle, const sf::Time* durations,
+							  std::size_t count, std::size_t index);
 
-    static void replace(frames_ptr* frm_ptr, const frame& other,
+    static void replace(frames_handle* handle, const frame& other,
                         std::size_t index,
                         const sf::IntRect& rect = sf::IntRect());
-    static void apply_tex_rect(frames_ptr* frm_ptr, const sf::IntRect& tex_rect);
-
-	static bool remove_frame(const frames_ptr& frm_ptr);
-	static void tidy();
+    static void apply_tex_rect(frames_handle* handle,
+                               const sf::IntRect& tex_rect);
 
 	static frame intersect(const frame& lhs,
                            const sf::IntRect& rhs);
 
+	static std::size_t live();
+	static std::size_t allocations(frames_handle handle);
+	static alloc_statistics alloc_stats();
+
 private :
 
+	// Friends
+
+	//! Lets the tests check the generation stamps, see frame_repos_test.cpp.
+	friend class frame_repository_probe;
+
+	// Member types
+
+	//! Slot holding the frames of a handle.
+	struct frame_slot {
+
+		//! Stored frames.
+		frame_storage frames;
+		//! Generation of the slot, increased on every release.
+		std::uint32_t generation;
+		//! Number of handles referring to the slot, zero if it is free.
+		std::uint32_t refs;
+		//! Hash of the frames, valid while interned.
+		std::uint64_t hash;
+		//! True while the frames are registered inside the intern table.
+		bool interned;
+		//! True if the frames have been changed since the last intern().
+		bool dirty;
+		//! Texture rectangle applied to the frames, see apply_tex_rect().
+		sf::IntRect tex_rect;
+		//! Generation of the texture rectangle, increased on every change.
+		std::uint32_t rect_gen;
+		//! Generation each frame with the applied texture rectangle has been
+		//! calculated for, it is outdated if it differs from rect_gen.
+		pool_vector<std::uint32_t> rect_stamps;
+		//! Quad of each frame with the applied texture rectangle.
+		pool_vector<frame_quad> quads;
+		//! Generation of the quads, increased whenever they may be outdated.
+		std::uint32_t quad_gen;
+		//! Generation each quad has been built for.
+		pool_vector<std::uint32_t> quad_stamps;
+		//! Duration of each frame, zero for the default duration.
+		pool_vector<sf::Time> durations;
+		//! Number of blocks requested from the frame_pool for the frames since
+		//! their creation.
+		std::size_t allocations;
+
+	};
+
+	//! Intern table, whose nodes come from the frame_pool.
+	typedef std::unordered_multimap<std::uint64_t, std::uint32_t,
+									std::hash<std::uint64_t>,
+									std::equal_to<std::uint64_t>,
+									pool_allocator<std::pair<
+										const std::uint64_t, std::uint32_t>>>
+		intern_table;
+
+	// Member functions
+
+	static frame_slot& slot(frames_handle handle);
+	static frame_slot& own(frames_handle* handle);
+	static void grow(frame_slot& target, const frame* frms,
+					 const frame* clipped, std::size_t count,
+					 std::size_t index);
+	static void resolve(frame_slot& target);
+	static void resolve(frame_slot& target, std::size_t index);
+	static void update(frame_slot& target, std::size_t first,
+					   std::size_t count);
+	static std::size_t outdated(frames_handle handle);
+	static void next_gen(std::uint32_t* gen,
+						 pool_vector<std::uint32_t>* stamps);
+	static frames_handle make_handle(std::uint32_t index);
+	static void unintern(std::uint32_t index);
+	static std::uint64_t hash_frames(const frame_storage& frames,
+									 const sf::IntRect& tex_rect);
+	static void clip(const frame_set& orig, const sf::IntRect& rect,
+					 frame_set* clipped, std::size_t first, std::size_t count);
+	static frame clip(const frame& frm, int left, int top, int right,
+					  int bottom);
+
 	// Member variables
 
-	static std::list<frames_ptr> m_frames;
-	static std::size_t destruct_count;
+	static std::vector<frame_slot> m_slots;
+	static std::vector<std::uint32_t> m_free;
+	static intern_table m_interned;
+	static std::size_t m_lifetimes;
+	static std::size_t m_lifetime_allocations;
 	
 };
 
 #endif
-
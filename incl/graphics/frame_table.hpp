@@ -0,0 +1,283 @@
+// frame_table - Frames of a frame group expanded at compile time.
+// frame_table.hpp
+
+#ifndef _FRAMETABLE_
+#define _FRAMETABLE_
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <cstddef>
+#ifndef _FRAME_
+#include "frame.hpp"
+#endif
+#ifndef _FRAMEREPOSITORY_
+#include "frame_repos.hpp"
+#endif
+
+//! List of indices, for expanding arrays from parameter packs.
+template <std::size_t... I>
+struct index_list {
+};
+
+//! Joins two index lists, the second continuing after the first.
+template <typename first, typename second>
+struct join_index_list;
+
+template <std::size_t... I, std::size_t... J>
+struct join_index_list<index_list<I...>, index_list<J...>> {
+
+	typedef index_list<I..., (sizeof...(I) + J)...> type;
+
+};
+
+//! Index list from zero to N - 1.
+/*!
+* Built by halving, so the nesting of the templates only grows with log(N)
+* and big sheets do not hit the instantiation depth of the compiler.
+*/
+template <std::size_t N>
+struct make_index_list {
+
+	typedef typename join_index_list<
+		typename make_index_list<N / 2>::type,
+		typename make_index_list<N - N / 2>::type>::type type;
+
+};
+
+template <>
+struct make_index_list<0> {
+
+	typedef index_list<> type;
+
+};
+
+template <>
+struct make_index_list<1> {
+
+	typedef index_list<0> type;
+
+};
+
+//! Positions of the frames of a grid as constexpr arrays.
+/*!
+* The frames are numbered row by row, like by animation::insert().
+*/
+template <int X, int Y, int W, int H, std::size_t cols, typename indices>
+struct frame_grid;
+
+template <int X, int Y, int W, int H, std::size_t cols, std::size_t... I>
+struct frame_grid<X, Y, W, H, cols, index_list<I...>> {
+
+	//! X-coordinates of the frames.
+	static constexpr int x[sizeof...(I)] = {
+		(X + static_cast<int>(I % cols) * W)...
+	};
+	//! Y-coordinates of the frames.
+	static constexpr int y[sizeof...(I)] = {
+		(Y + static_cast<int>(I / cols) * H)...
+	};
+
+};
+
+template <int X, int Y, int W, int H, std::size_t cols, std::size_t... I>
+constexpr int frame_grid<X, Y, W, H, cols, index_list<I...>>::x[
+	sizeof...(I)];
+
+template <int X, int Y, int W, int H, std::size_t cols, std::size_t... I>
+constexpr int frame_grid<X, Y, W, H, cols, index_list<I...>>::y[
+	sizeof...(I)];
+
+//! Part of a frame covered by a texture rectangle, at compile time.
+struct frame_cover {
+
+	//! Smaller of two values.
+	static constexpr int lower(int a, int b) {
+
+		return a < b ? a : b;
+
+	}
+
+	//! Bigger of two values.
+	static constexpr int upper(int a, int b) {
+
+		return a < b ? b : a;
+
+	}
+
+	//! Part of a frame covered by the texture rectangle along one axis.
+	/*!
+	* Like frame_repository::intersect(), the frame spans from zero to its
+	* size and rectangles may have a negative size.
+	* \param size Size of the frame.
+	* \param start Start of the texture rectangle.
+	* \param length Size of the texture rectangle.
+	* \return Covered length, zero or less if nothing is covered.
+	*/
+	static constexpr int cover(int size, int start, int length) {
+
+		return lower(upper(0, size), upper(start, start + length)) -
+			   upper(lower(0, size), lower(start, start + length));
+
+	}
+
+};
+
+//! Frames of a frame group, expanded at compile time.
+/*!
+* For sprite sheets whose layout is known at build time. The parameters are
+* those of a frame_group (position and size of the section, size of the
+* frames) and optionally a texture rectangle. The positions of all frames,
+* their size with the applied texture rectangle and the biggest frame size are
+* calculated by the compiler, so nothing has to be split at runtime:
+*
+*     typedef frame_table<0, 0, 640, 192, 64, 96> walk_table;
+*     static_assert(20 == walk_table::count, "walk cycle has 20 frames");
+*
+*     animation walk;
+*     walk.bind<walk_table>();
+*
+* All frames of a frame group have the same size, so the frames with the
+* applied texture rectangle share the positions of the frames and have a
+* single size, clipped_width and clipped_height.
+*
+* The frames are stored inside the frame_repository once, on the first call of
+* handle(), and shared by all animations bound to the table afterwards. So
+* binding an animation only copies a handle. An animation changing the frames
+* gets its own copy of them, see frame_repository::edit().
+*/
+template <int X, int Y, int SW, int SH, int W, int H,
+		  int RL = 0, int RT = 0, int RW = 0, int RH = 0>
+class frame_table {
+
+	static_assert(0 < W && 0 < H, "frames need a positive size");
+	static_assert(W <= SW && H <= SH, "section has to hold a frame");
+
+public :
+
+	// Member variables
+
+	//! Number of rows of frames.
+	static constexpr std::size_t rows = SH / H;
+	//! Number of frames per row.
+	static constexpr std::size_t cols = SW / W;
+	//! Number of frames.
+	static constexpr std::size_t count = rows * cols;
+	//! Size of the frames, the biggest size of the animation.
+	static constexpr int width = W;
+	//! Size of the frames, the biggest size of the animation.
+	static constexpr int height = H;
+
+private :
+
+	// Member variables
+
+	//! True if the texture rectangle is empty, i.e. not used.
+	static constexpr bool no_rect = 0 == RL && 0 == RT && 0 == RW && 0 == RH;
+	//! Width of the frames covered by the texture rectangle.
+	static constexpr int cover_w = frame_cover::cover(W, RL, RW);
+	//! Height of the frames covered by the texture rectangle.
+	static constexpr int cover_h = frame_cover::cover(H, RT, RH);
+	//! True if the texture rectangle intersects the frames.
+	static constexpr bool hit = 0 < cover_w && 0 < cover_h;
+
+public :
+
+	//! Width of the frames with the applied texture rectangle.
+	static constexpr int clipped_width = no_rect ? W : (hit ? cover_w : 0);
+	//! Height of the frames with the applied texture rectangle.
+	static constexpr int clipped_height = no_rect ? H : (hit ? cover_h : 0);
+
+	//! Positions of the frames.
+	typedef frame_grid<X, Y, W, H, cols,
+					   typename make_index_list<count>::type> grid;
+
+	// Member functions
+
+	//! Texture rectangle applied to the frames.
+	static sf::IntRect tex_rect() {
+
+		return sf::IntRect(RL, RT, RW, RH);
+
+	}
+
+	//! Handle of the frames inside the frame_repository.
+	/*!
+	* Stores the frames on the first call. The handle is never released, so
+	* the frames stay until the end of the program.
+	* \return Handle of the frames, to be acquired by every user.
+	*/
+	static frames_handle handle() {
+
+		static const frames_handle shared = store();
+
+		return shared;
+
+	}
+
+private :
+
+	//! Store the frames inside the frame_repository.
+	/*!
+	* \return Handle of the stored frames.
+	*/
+	static frames_handle store() {
+
+		std::vector<frame> frms;
+		std::vector<frame> clipped;
+		frms.reserve(count);
+		clipped.reserve(count);
+
+		for (std::size_t i = 0; i < count; ++ i) {
+
+			frms.push_back(frame(grid::x[i], grid::y[i], W, H));
+			clipped.push_back(frame(grid::x[i], grid::y[i], clipped_width,
+									clipped_height));
+
+		}
+
+		// Set the texture rectangle first, so the clipped frames are up to
+		// date and nothing is calculated again.
+		frames_handle frames = NO_FRM;
+		frame_repository::create(&frames);
+		frame_repository::apply_tex_rect(&frames, tex_rect());
+		frame_repository::insert(&frames, frms.data(), clipped.data(), count,
+								 0);
+		frame_repository::intern(&frames);
+
+		return frames;
+
+	}
+
+};
+
+template <int X, int Y, int SW, int SH, int W, int H,
+		  int RL, int RT, int RW, int RH>
+constexpr std::size_t frame_table<X, Y, SW, SH, W, H, RL, RT, RW, RH>::rows;
+
+template <int X, int Y, int SW, int SH, int W, int H,
+		  int RL, int RT, int RW, int RH>
+constexpr std::size_t frame_table<X, Y, SW, SH, W, H, RL, RT, RW, RH>::cols;
+
+template <int X, int Y, int SW, int SH, int W, int H,
+		  int RL, int RT, int RW, int RH>
+constexpr std::size_t frame_table<X, Y, SW, SH, W, H, RL, RT, RW, RH>::count;
+
+template <int X, int Y, int SW, int SH, int W, int H,
+		  int RL, int RT, int RW, int RH>
+constexpr int frame_table<X, Y, SW, SH, W, H, RL, RT, RW, RH>::width;
+
+template <int X, int Y, int SW, int SH, int W, int H,
+		  int RL, int RT, int RW, int RH>
+constexpr int frame_table<X, Y, SW, SH, W, H, RL, RT, RW, RH>::height;
+
+template <int X, int Y, int SW, int SH, int W, int H,
+		  int RL, int RT, int RW, int RH>
+constexpr int
+	frame_table<X, Y, SW, SH, W, H, RL, RT, RW, RH>::clipped_width;
+
+template <int X, int Y, int SW, int SH, int W, int H,
+		  int RL, int RT, int RW, int RH>
+constexpr int
+	frame_table<X, Y, SW, SH, W, H, RL, RT, RW, RH>::clipped_height;
+
+#endif // _FRAMETABLE_
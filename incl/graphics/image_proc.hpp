@@ -0,0 +1,46 @@
+// image_proc - Processing of images on the CPU.
+// image_proc.hpp
+
+#ifndef _IMAGEPROC_
+#define _IMAGEPROC_
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#ifndef _FRAME_
+#include "frame.hpp"
+#endif
+
+//! Static class for processing images before they are uploaded.
+/*!
+* Holds functions which modify the pixels of an image on the CPU, so the
+* texture only gets the pixels which are actually needed.
+*/
+class image_proc {
+
+public :
+
+	// Member functions
+
+	static sf::Image crop(const sf::Image& image, const sf::IntRect& area);
+	static sf::Image resample(const sf::Image& image, const sf::Vector2u& size);
+	static sf::Vector2u target_size(const sf::Vector2u& image_size,
+									const sf::Vector2u& size);
+
+	static frame trim(const sf::Image& image, const frame& cell,
+					  sf::Uint8 threshold = 0);
+	static std::vector<frame> slice(const sf::Image& image,
+									const frame_group& frm_grp,
+									sf::Uint8 threshold = 0);
+
+private :
+
+	// Member functions
+
+	static int first_opaque(const sf::Uint8* row, int begin, int end,
+							sf::Uint8 threshold);
+	static int last_opaque(const sf::Uint8* row, int begin, int end,
+						   sf::Uint8 threshold);
+
+};
+
+#endif // _IMAGEPROC_
@@ -0,0 +1,55 @@
+// lz_codec - Fast lossless compression of pixel data.
+// lz_codec.hpp
+
+#ifndef _LZCODEC_
+#define _LZCODEC_
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+//! Static class for compressing blocks of memory.
+/*!
+* A byte oriented LZ77 codec in the spirit of LZ4, tuned for speed instead of
+* ratio: decompressing is little more than copying memory. It is used to keep
+* evicted textures in RAM at a fraction of their size.
+*
+* A block is a list of sequences. Each sequence starts with a token, whose
+* upper four bits hold the number of literals and whose lower four bits hold
+* the length of the match minus four. A value of 15 is continued by extra
+* bytes, which are added up until one is not 255. The literals follow, then
+* the offset of the match as 16 bit little endian value. The last sequence of
+* a block only holds literals.
+*
+* The size of the uncompressed data is not stored, the caller has to keep it.
+*/
+class lz_codec {
+
+public :
+
+	// Member functions
+
+	static std::vector<std::uint8_t> compress(const std::uint8_t* data,
+											  std::size_t size);
+	static bool decompress(const std::uint8_t* data, std::size_t size,
+						   std::uint8_t* out, std::size_t out_size);
+
+private :
+
+	// Member functions
+
+	static void put_length(std::vector<std::uint8_t>* out, std::size_t length);
+	static bool get_length(const std::uint8_t** in, const std::uint8_t* end,
+						   std::size_t* length);
+	static std::uint32_t read32(const std::uint8_t* data);
+	static std::uint32_t hash32(std::uint32_t value);
+
+	// Member variables
+
+	static const std::size_t min_match = 4;
+	static const std::size_t max_offset = 65535;
+	static const unsigned int hash_bits = 12;
+
+};
+
+#endif // _LZCODEC_
@@ -0,0 +1,58 @@
+// mapped_file - Read-only memory mapping of a file.
+// mapped_file.hpp
+
+#ifndef _MAPPEDFILE_
+#define _MAPPEDFILE_
+
+#include <string>
+#include <memory>
+#include <cstddef>
+
+//! Read-only memory mapping of a whole file.
+/*!
+* Maps a file into memory, so its content can be handed directly to a decoder
+* like sf::Image::loadFromMemory(), without reading it into a buffer first. The
+* pages of the file are loaded by the operating system once they are accessed,
+* and shared with its file cache.
+*
+* The mapping is released by close() or on destruction. Since it must not be
+* released twice, the class cannot be copied; use mapped_file_ptr to share it.
+*/
+class mapped_file {
+
+public :
+
+	// Member functions
+
+	mapped_file();
+	~mapped_file();
+
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+
+	bool open(const std::string& filename);
+	void close();
+
+	bool is_open() const;
+	const void* data() const;
+	std::size_t size() const;
+
+private :
+
+	// Member variables
+
+	//! Start of the mapping, null if no file is mapped.
+	void* m_data;
+	//! Size of the mapping in bytes.
+	std::size_t m_size;
+#ifdef _WIN32
+	//! Handle of the file mapping object.
+	void* m_mapping;
+#endif
+
+};
+
+//! Type to share a mapping.
+typedef std::shared_ptr<mapped_file> mapped_file_ptr;
+
+#endif // _MAPPEDFILE_
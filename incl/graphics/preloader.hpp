@@ -0,0 +1,124 @@
+// preloader - Parallel loading of the resources listed in a manifest.
+// preloader.hpp
+
+#ifndef _PRELOADER_
+#define _PRELOADER_
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include <memory>
+#include <ostream>
+#ifndef _TEXTUREREPOSITORY_
+#include "texture_repos.hpp"
+#endif
+
+//! Loads resources in parallel and measures how long it takes.
+/*!
+* The resources needed at startup are listed inside a manifest, one per line:
+*
+*     # kind    name        path                    options
+*     font      font        res/NotoSerif-Regular.ttf
+*     texture   background  res/background.jpg      size=desktop
+*     atlas     wymon       res/wymon.png           area=0,0,106,96
+*
+* The kind is one of font, image (stays in RAM), texture or atlas (see
+* texture_repository::load_atlas()). The optional area (left, top, width,
+* height) selects a part of the image, the optional size (width, height, or
+* desktop for the size of the desktop) the size a texture is scaled down to.
+* Empty lines and lines starting with # are ignored.
+*
+* load() decodes all resources at the same time on the shared worker_pool,
+* while the calling thread uploads each texture as soon as it is decoded. The
+* textures are registered inside the texture_repository under their path, so
+* loading them again afterwards, e.g. with Textureable::load(), is served by
+* the cache. The preloader keeps them alive as long as it exists.
+*
+* The time each resource takes to decode and to upload is recorded, as well as
+* the time until the first frame is shown, so slow resources become visible,
+* see report().
+*/
+class preloader {
+
+public :
+
+	// Member types
+
+	//! Kind of a resource.
+	enum kind {
+
+		FONT,
+		IMAGE,
+		TEXTURE,
+		ATLAS
+
+	};
+
+	//! Single resource of the manifest.
+	struct asset {
+
+		//! Kind of the resource.
+		kind type;
+		//! Name to find the resource by.
+		std::string name;
+		//! Path of the file.
+		std::string path;
+		//! Area of the image to load, empty for the whole image.
+		sf::IntRect area;
+		//! Size to scale a texture down to, zero to keep its size.
+		sf::Vector2u size;
+		//! Loaded font, if the resource is a font.
+		std::shared_ptr<sf::Font> font;
+		//! Decoded image, if the resource is an image.
+		std::shared_ptr<sf::Image> image;
+		//! Texture, or atlas page, if the resource is a texture.
+		texture_ptr tex;
+		//! Area of the texture holding the image.
+		sf::IntRect rect;
+		//! Time it took to decode the file.
+		sf::Time decode_time;
+		//! Time it took to upload the texture.
+		sf::Time upload_time;
+		//! True once the resource has been loaded successfully.
+		bool loaded;
+
+	};
+
+	// Member functions
+
+	preloader();
+
+	bool manifest(const std::string& filename);
+	void add(kind type, const std::string& name, const std::string& path,
+			 const sf::IntRect& area = sf::IntRect(),
+			 const sf::Vector2u& size = sf::Vector2u());
+
+	bool load();
+
+	const asset* find(const std::string& name) const;
+	const std::vector<asset>& assets() const;
+
+	void first_frame();
+	void report(std::ostream& out) const;
+
+private :
+
+	// Member functions
+
+	static void decode(asset& item);
+	static bool upload(asset& item);
+
+	// Member variables
+
+	//! Resources to load, in the order of the manifest.
+	std::vector<asset> m_assets;
+	//! Runs since the construction, i.e. since the start of the startup.
+	sf::Clock m_clock;
+	//! Time load() took to load all resources.
+	sf::Time m_load_time;
+	//! Time from the construction until the first frame, zero until then.
+	sf::Time m_first_frame;
+
+};
+
+#endif // _PRELOADER_
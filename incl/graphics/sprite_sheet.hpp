@@ -0,0 +1,137 @@
+// sprite_sheet - Frame layout of a sprite sheet.
+// sprite_sheet.hpp
+
+#ifndef _SPRITESHEET_
+#define _SPRITESHEET_
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#ifndef _FRAME_
+#include "frame.hpp"
+#endif
+
+//! Frames, clips and frame durations of a sprite sheet.
+/*!
+* Describes where the frames of an animation are located on its sprite sheet,
+* so the layout is stored next to the sheet instead of inside the code. The
+* layout is a list of frame groups, a single frame being a group holding one
+* frame. Each group has a duration, which is used for all of its frames, zero
+* meaning the default duration of the animation. Clips are named ranges of
+* frames, e.g. a walk cycle.
+*
+* The descriptor is written in a text form, one entry per line:
+*
+*     # frame x y w h [duration in ms]
+*     frame  0 0 106 96 850
+*     # group x y section_width section_height w h [duration in ms]
+*     group  0 96 640 96 64 96 100
+*     # clip name first_frame frame_count
+*     clip   idle 0 2
+*
+* Empty lines and lines starting with # are ignored. convert() turns it into
+* the binary form, which is what load() reads at runtime. The binary form is
+* little endian and consists of:
+*
+*     header   magic "WOSS", version, entry count, clip count, frame count
+*              and size of the clip names, each as 32 bit value
+*     entries  x, y, section width and height, frame width and height and
+*              duration in ms of each group, each as 32 bit value
+*     clips    first frame, frame count and name length of each clip, each as
+*              32 bit value
+*     names    names of all clips, without terminating zero
+*
+* The file is mapped into memory and read in a single pass, expanding the
+* groups directly into the frame list, so the frames can be inserted into an
+* animation all at once, see animation::insert().
+*/
+class sprite_sheet {
+
+public :
+
+	// Member types
+
+	//! Named range of frames.
+	struct clip {
+
+		//! Name of the clip.
+		std::string name;
+		//! Index of the first frame.
+		std::size_t first;
+		//! Number of frames.
+		std::size_t count;
+
+	};
+
+	// Member functions
+
+	sprite_sheet();
+
+	bool load(const std::string& filename);
+	bool load_text(const std::string& filename);
+	bool save(const std::string& filename) const;
+	static bool convert(const std::string& text_file,
+						const std::string& binary_file);
+
+	void add(const frame& frm, sf::Time duration = sf::Time::Zero);
+	void add(const frame_group& frm_grp, sf::Time duration = sf::Time::Zero);
+	bool add_clip(const std::string& name, std::size_t first,
+				  std::size_t count);
+	void clear();
+
+	const std::vector<frame>& frames() const;
+	const std::vector<sf::Time>& durations() const;
+	const std::vector<clip>& clips() const;
+	const clip* find(const std::string& name) const;
+
+private :
+
+	// Member types
+
+	//! Group of frames as defined by the descriptor.
+	struct entry {
+
+		//! Position and size of the section and the frames.
+		frame_group group;
+		//! Duration of each frame in ms, zero for the default duration.
+		std::uint32_t duration;
+
+	};
+
+	// Member functions
+
+	static std::size_t cells(const frame_group& frm_grp);
+	static std::uint32_t to_ms(sf::Time duration);
+	void expand(const entry& item);
+	static std::uint32_t read32(const std::uint8_t* data);
+	static void put32(std::vector<std::uint8_t>* out, std::uint32_t value);
+
+	// Member variables
+
+	//! Groups in the order of the descriptor.
+	std::vector<entry> m_entries;
+	//! Frames of all groups, row by row.
+	std::vector<frame> m_frames;
+	//! Duration of each frame, zero for the default duration.
+	std::vector<sf::Time> m_durations;
+	//! Clips in the order of the descriptor.
+	std::vector<clip> m_clips;
+
+	//! Version of the binary form.
+	static const std::uint32_t version = 1;
+	//! Number of 32 bit values of the header, including the magic.
+	static const std::size_t header_values = 6;
+	//! Number of 32 bit values of an entry.
+	static const std::size_t entry_values = 7;
+	//! Number of 32 bit values of a clip.
+	static const std::size_t clip_values = 3;
+	//! Longest frame duration in ms, the range of sf::milliseconds().
+	static const std::uint32_t max_duration = 2147483647;
+	//! Most frames the binary form may hold, far more than any sheet needs.
+	static const std::size_t max_frames = 1 << 20;
+
+};
+
+#endif // _SPRITESHEET_
@@ -56,18 +56,31 @@ public :
 
 	bool load(const std::string& filename,
               const sf::IntRect& displ_rect = sf::IntRect(),
-			  const sf::IntRect& load_rect = sf::IntRect());
+			  const sf::IntRect& load_rect = sf::IntRect(),
+			  const sf::Vector2u& tex_size = sf::Vector2u());
 	bool load(const void* data, std::size_t size,
               const sf::IntRect& displ_rect = sf::IntRect(),
-			  const sf::IntRect& load_rect = sf::IntRect());
+			  const sf::IntRect& load_rect = sf::IntRect(),
+			  const sf::Vector2u& tex_size = sf::Vector2u());
 	bool load(sf::InputStream& stream,
 			  const sf::IntRect& displ_rect = sf::IntRect(),
-			  const sf::IntRect& load_rect = sf::IntRect());
+			  const sf::IntRect& load_rect = sf::IntRect(),
+			  const sf::Vector2u& tex_size = sf::Vector2u());
 	bool load(const sf::Image& image,
 			  const sf::IntRect& displ_rect = sf::IntRect(),
-			  const sf::IntRect& load_rect = sf::IntRect());
+			  const sf::IntRect& load_rect = sf::IntRect(),
+			  const sf::Vector2u& tex_size = sf::Vector2u());
+	std::shared_future<bool> load_async(const std::string& filename,
+							const sf::IntRect& displ_rect = sf::IntRect(),
+							const sf::IntRect& load_rect = sf::IntRect(),
+							const sf::Vector2u& tex_size = sf::Vector2u());
+	bool sync();
+	bool load_atlas(const std::string& filename,
+					const sf::IntRect& displ_rect = sf::IntRect(),
+					const sf::IntRect& load_rect = sf::IntRect());
 
 	void setTexture(const sf::Texture& texture, bool resetRect = false);
+	void setTexture(const texture_ptr& texture, bool resetRect = false);
 	//! Set the render rectangle, which the sprite will display.
 	/*!
 	* ATTENTION: This is a pure virtual function. The classes
@@ -100,6 +113,7 @@ protected :
     virtual void updateTexCoords() = 0;
 
 	void appl_displ_rect(const sf::IntRect& displ_rect);
+	sf::Vector2u tex_size() const;
 
 	//! Draw the sprite to a render target.
 	/*!
@@ -127,6 +141,22 @@ protected :
 	* display.
 	*/
     sf::IntRect mTexRect;
+	//! Area of the texture holding the image of this object.
+	/*!
+	* If the texture is shared with other images, like a page of an atlas, this
+	* is the area of the texture which holds the image. The texture rectangle
+	* and the frames of an animation are relative to this area. An empty area
+	* means the image is the whole texture.
+	*/
+	sf::IntRect m_tex_area;
+	//! Asynchronous load which has not been synchronized yet.
+	/*!
+	* Is only valid between load_async() and the sync() call which noticed
+	* that the texture has been uploaded.
+	*/
+	std::shared_future<bool> m_pending;
+	//! Display rectangle to apply once the pending load is done.
+	sf::IntRect m_pending_rect;
 
 };
 
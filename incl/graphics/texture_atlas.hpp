@@ -0,0 +1,106 @@
+// texture_atlas - Shared texture pages for small images.
+// texture_atlas.hpp
+
+#ifndef _TEXTUREATLAS_
+#define _TEXTUREATLAS_
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <memory>
+#ifndef _TEXTUREREPOSITORY_
+#include "texture_repos.hpp"
+#endif
+
+//! Packs small images into shared texture pages.
+/*!
+* Every texture which is drawn needs its own bind, so drawing many small
+* textures one after another is expensive. This class packs small images into
+* a few big textures, the pages, so objects sharing a page can be drawn without
+* rebinding. An inserted image is identified by its page and the rectangle it
+* occupies on that page.
+*
+* The images are placed with a skyline bottom-left packer: the upper border of
+* the used space of a page is stored as a list of horizontal segments, the
+* skyline, and each image is put where its bottom edge ends up the lowest.
+*
+* The pages can be created by a factory, e.g. so the texture_repository
+* accounts for their memory like for any other texture.
+*
+* ATTENTION: The space of an image is never given back, the pages live as
+* long as the atlas. So only images which are needed for the whole runtime
+* should be put inside an atlas.
+*/
+class texture_atlas {
+
+public :
+
+	// Member types
+
+	//! Function creating an empty page.
+	/*!
+	* Gets the width and height of the page and its index, and returns the
+	* texture, or null if it could not be created.
+	*/
+	typedef texture_ptr (*page_factory)(unsigned int size, std::size_t index);
+
+	// Member functions
+
+	explicit texture_atlas(unsigned int page_size = 1024,
+						   unsigned int padding = 1,
+						   page_factory factory = nullptr);
+
+	bool insert(const sf::Image& image, texture_ptr* page, sf::IntRect* rect);
+	bool fits(const sf::Vector2u& size) const;
+
+	std::size_t pages() const;
+
+private :
+
+	// Member types
+
+	//! Horizontal segment of the skyline.
+	struct skyline_node {
+
+		//! Left end of the segment.
+		int x;
+		//! Height of the used space below the segment.
+		int y;
+		//! Width of the segment.
+		int w;
+
+	};
+
+	//! Single texture page.
+	struct page {
+
+		//! Texture holding the images.
+		texture_ptr tex;
+		//! Skyline of the page, sorted by x, covering the whole width.
+		std::vector<skyline_node> skyline;
+
+	};
+
+	// Member functions
+
+	bool add_page();
+	bool find(const page& pg, int width, int height, std::size_t* index,
+			  sf::Vector2i* pos) const;
+	bool fits(const page& pg, std::size_t index, int width, int height,
+			  int* y) const;
+	void place(page& pg, std::size_t index, const sf::Vector2i& pos,
+			   int width, int height);
+
+	// Member variables
+
+	//! Width and height of the pages.
+	unsigned int m_page_size;
+	//! Empty pixels kept between images, so they do not bleed into each other.
+	unsigned int m_padding;
+	//! Creates the pages, null for plain textures.
+	page_factory m_factory;
+	//! All pages of the atlas.
+	std::vector<page> m_pages;
+
+};
+
+#endif // _TEXTUREATLAS_
@@ -0,0 +1,93 @@
+// texture_bake - Cache of decoded images on disk.
+// texture_bake.hpp
+
+#ifndef _TEXTUREBAKE_
+#define _TEXTUREBAKE_
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include <cstdint>
+
+//! Static class to bake decoded images into cache files.
+/*!
+* Decoding PNG or JPEG files takes a lot of time, and it is done for the same
+* files on every start of the program. This class stores the decoded pixels of
+* an image inside a cache file, a baked image, which can be uploaded with a
+* single mapping of the file and without any decoding.
+*
+* A baked image consists of a header followed by the raw RGBA pixels. The
+* header holds the size of the image, as well as the size and the modification
+* time of the source file at the time of baking. An image is baked the way it
+* is uploaded, so only the loaded area is stored, and it is stored already
+* scaled down to the target size, see image_proc::resample(). If the source
+* file has been modified since, the baked image is stale and ignored.
+*
+* Baking is disabled until a directory for the cache files is set with dir().
+* Once it is set, the texture_repository bakes every file it decodes, so the
+* next start of the program can use the baked image. Files can also be baked
+* in advance with bake().
+*
+* NOTE: The directory has to be set before any loading starts, since baked
+* images are also read and written by the worker threads.
+*/
+class texture_bake {
+
+public :
+
+	// Member functions
+
+	static void dir(const std::string& path);
+	static const std::string& dir();
+
+	static bool bake(const std::string& filename,
+					 const sf::IntRect& area = sf::IntRect(),
+					 const sf::Vector2u& size = sf::Vector2u());
+
+	static bool read(const std::string& filename, const sf::IntRect& area,
+					 const sf::Vector2u& size, sf::Image* image);
+	static bool upload(const std::string& filename, const sf::IntRect& area,
+					   const sf::Vector2u& size, sf::Texture* tex);
+	static bool write(const std::string& filename, const sf::IntRect& area,
+					  const sf::Vector2u& size, const sf::Image& image);
+
+private :
+
+	// Member types
+
+	//! Header of a baked image.
+	struct header {
+
+		//! Identifies the file as baked image, always "WOTB".
+		char magic[4];
+		//! Version of the format.
+		std::uint32_t version;
+		//! Width of the image.
+		std::uint32_t width;
+		//! Height of the image.
+		std::uint32_t height;
+		//! Hash of the source file path, the area and the target size.
+		std::uint64_t key;
+		//! Size of the source file at the time of baking.
+		std::uint64_t source_size;
+		//! Modification time of the source file at the time of baking.
+		std::int64_t source_mtime;
+
+	};
+
+	// Member functions
+
+	static std::string path(const std::string& filename,
+							const sf::IntRect& area, const sf::Vector2u& size,
+							std::uint64_t* key);
+	static bool source_info(const std::string& filename, header* head);
+	static const unsigned char* pixels(const std::string& filename,
+									   const void* data, std::size_t size,
+									   header* head);
+
+	// Member variables
+
+	static std::string m_dir;
+
+};
+
+#endif // _TEXTUREBAKE_
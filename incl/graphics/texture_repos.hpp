@@ -6,16 +6,32 @@
 #include <SFML/Graphics.hpp>
 #include <string>
 #include <list>
+#include <map>
+#include <unordered_map>
 #include <memory>
+#include <future>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <array>
+#include <ostream>
+#ifndef _MAPPEDFILE_
+#include "mapped_file.hpp"
+#endif
 
 //! Type to conveniently work with shared textures.
 /*!
 * This type uses the ability of std::shared_ptr to count the number of
-* references currently in use. If only the texture container refers to the
-* texture, it will be deleted out of the memory.
+* references currently in use. Once the last reference to a texture loaded by
+* the texture_repository is released, the texture is removed from the
+* repository and deleted out of the memory.
 */
 typedef std::shared_ptr<sf::Texture> texture_ptr;
 
+class texture_atlas;
+
 //! Static class to automatically handle textures.
 /*!
 * In the SFML, a sprite only holds a pointer to a sf::Texture object, which
@@ -26,31 +42,368 @@ typedef std::shared_ptr<sf::Texture> texture_ptr;
 * objects, but not accidently destroyed during runtime. Therefore the code will
 * be much cleaner an easier to handle; Sprite objects should most likely be the
 * only object which has to be taken care of.
+*
+* The list only holds weak references to the textures. The textures are created
+* with a deleter which removes them from the list in constant time, once their
+* last reference is released. So there is no need to tidy up the list, and it
+* still allows to enumerate all live textures.
+*
+* Every loaded texture is also registered inside a cache, keyed by its source
+* (file path, or a hash of the data in memory) and the loaded area. Loading the
+* same source and area a second time hands back the already existing texture,
+* instead of decoding and uploading the image once again.
+*
+* Files can also be loaded asynchronously with load_async(). The image is then
+* decoded by the shared worker_pool, while the texture holds a placeholder. The
+* decoded image is uploaded by upload_pending(), which has to be called by the
+* render thread, preferably once per frame. The decoding can also be done by
+* the caller with decode() on any thread, and the result be uploaded with
+* load_decoded(), see preloader.
+*
+* Several areas of the same source, like the frames of a sprite sheet, can be
+* loaded as views with load_view(). Instead of a texture holding a copy of the
+* area, every view gets the texture of the whole source, which is loaded only
+* once, and the rectangle of the area on it.
+*
+* Small images, which are used for the whole runtime, can be put into the
+* atlas with load_atlas(). Instead of an own texture, they get a page of the
+* atlas shared with other images and the rectangle they occupy on it. The
+* pages are held by the repository like any other texture, so they count
+* towards the statistics and the budget, but they are never evicted.
+*
+* The memory the textures take up on the graphics card can be limited with
+* budget(). The textures are kept in the order they have been used, drawing a
+* texture has to be reported with touch(). Once the budget is exceeded, the
+* least recently used textures are evicted: the texture object stays valid, but
+* its pixels are released. Its size is still reported by size(), which is what
+* the sizing of objects has to rely on. Only the path of the source file, or a
+* compressed copy of the pixels in RAM if there is none, is kept. The next
+* touch() uploads the pixels again. With tier_budget(), the compressed copies
+* are also kept for textures loaded from files, so restoring them does not
+* decode the file.
+*
+* Files can also be loaded through a memory mapping with load_mapped(), which
+* hands the file to the decoder without copying it into a buffer first. The
+* mapping can be kept, so an evicted texture is decoded straight from memory
+* instead of reading the file again.
+*
+* All load functions take an optional target size. The image is then scaled
+* down on the CPU before the upload, so e.g. a background which is drawn at
+* screen size does not take up the memory of its much larger source image on
+* the graphics card, see image_proc::resample().
+*
+* Once a directory is set with texture_bake::dir(), every decoded file is baked
+* and the baked image is used instead of decoding the file, as long as the file
+* has not been modified, see texture_bake.
+*
+* The load functions (except load_async()) may be called from any thread, and
+* textures may be released on any thread. The textures are spread over a fixed
+* number of shards by the hash of their key, each with its own list, cache and
+* mutex, so threads loading different sources rarely wait for each other. A
+* texture knows its shard through its deleter. Eviction and restoring only
+* happen inside touch(), budget() and upload_pending(), which have to be called
+* from the render thread, so a texture is never evicted while it is drawn.
+* Other threads must not access the texture objects they get, since the render
+* thread may evict them at any time. Their size is taken from size() instead,
+* which the load functions and Textureable already do.
+*
+* What the repository holds and how it performs can be inspected at runtime
+* with stats(), or written as JSON with write_stats(), e.g. to track the
+* memory used by a build over time. Load latencies are counted in a histogram
+* whose buckets double in width, see latency_bound().
 */
 class texture_repository {
 
 public :
 
+	// Member types
+
+	//! Number of buckets of the load latency histogram.
+	static const std::size_t latency_buckets = 16;
+
+	//! Statistics of a single live texture.
+	struct source_stats {
+
+		//! Path of the source file, or the cache key if there is none.
+		std::string source;
+		//! Number of references held to the texture.
+		long refs;
+		//! Bytes the texture takes up on the graphics card when resident.
+		std::size_t bytes;
+		//! False while evicted.
+		bool resident;
+
+	};
+
+	//! Snapshot of the statistics of the repository.
+	struct statistics {
+
+		//! Number of live textures.
+		std::size_t live;
+		//! Bytes the resident textures take up on the graphics card.
+		std::size_t bytes;
+		//! Highest value bytes has reached so far.
+		std::size_t peak_bytes;
+		//! Budget of the graphics card memory, zero if there is none.
+		std::size_t budget;
+		//! Bytes the compressed tier takes up in RAM.
+		std::size_t tier_bytes;
+		//! Number of load calls served by the cache.
+		std::size_t hits;
+		//! Number of load calls which had to decode and upload an image.
+		std::size_t misses;
+		//! Number of textures evicted from the graphics card.
+		std::size_t evictions;
+		//! Number of evicted textures which have been restored.
+		std::size_t reloads;
+		//! Number of loads per latency bucket, see latency_bound().
+		std::array<std::size_t, latency_buckets> latency;
+		//! Every live texture.
+		std::vector<source_stats> sources;
+
+	};
+
 	// Member functions
 
 	static bool load(texture_ptr* tex_ptr, const std::string& filename,
-					 const sf::IntRect& area = sf::IntRect());
+					 const sf::IntRect& area = sf::IntRect(),
+					 const sf::Vector2u& size = sf::Vector2u());
 	static bool load(texture_ptr* tex_ptr, const void* data, std::size_t size,
-					 const sf::IntRect& area = sf::IntRect());
+					 const sf::IntRect& area = sf::IntRect(),
+					 const sf::Vector2u& tex_size = sf::Vector2u());
 	static bool load(texture_ptr* tex_ptr, sf::InputStream& stream,
-					 const sf::IntRect& area = sf::IntRect());
+					 const sf::IntRect& area = sf::IntRect(),
+					 const sf::Vector2u& size = sf::Vector2u());
 	static bool load(texture_ptr* tex_ptr, const sf::Image& image,
-					 const sf::IntRect& area = sf::IntRect());
+					 const sf::IntRect& area = sf::IntRect(),
+					 const sf::Vector2u& size = sf::Vector2u());
+	static bool load_mapped(texture_ptr* tex_ptr, const std::string& filename,
+							const sf::IntRect& area = sf::IntRect(),
+							const sf::Vector2u& size = sf::Vector2u(),
+							bool keep_mapping = false);
+
+	static std::shared_future<bool> load_async(texture_ptr* tex_ptr,
+									const std::string& filename,
+									const sf::IntRect& area = sf::IntRect(),
+									const sf::Vector2u& size = sf::Vector2u());
+	static std::size_t upload_pending();
+
+	static std::shared_ptr<sf::Image> decode(const std::string& filename,
+									const sf::IntRect& area = sf::IntRect(),
+									const sf::Vector2u& size = sf::Vector2u());
+	static bool load_decoded(texture_ptr* tex_ptr, const std::string& filename,
+							 const sf::Image& image,
+							 const sf::IntRect& area = sf::IntRect(),
+							 const sf::Vector2u& size = sf::Vector2u());
 
-    static bool remove_texture(const texture_ptr& tex_ptr);
-	static void tidy();
+	static bool load_atlas(texture_ptr* tex_ptr, sf::IntRect* rect,
+						   const std::string& filename,
+						   const sf::IntRect& area = sf::IntRect());
+	static bool load_atlas(texture_ptr* tex_ptr, sf::IntRect* rect,
+						   const std::string& filename, const sf::Image& image,
+						   const sf::IntRect& area = sf::IntRect());
+
+	static bool load_view(texture_ptr* tex_ptr, sf::IntRect* rect,
+						  const std::string& filename,
+						  const sf::IntRect& area = sf::IntRect());
+	static bool load_view(texture_ptr* tex_ptr, sf::IntRect* rect,
+						  const void* data, std::size_t size,
+						  const sf::IntRect& area = sf::IntRect());
+	static bool load_view(texture_ptr* tex_ptr, sf::IntRect* rect,
+						  const sf::Image& image,
+						  const sf::IntRect& area = sf::IntRect());
+
+	static std::size_t live();
+	static std::vector<texture_ptr> textures();
+	static texture_ptr find(const sf::Texture* tex);
+	static sf::Vector2u size(const texture_ptr& tex);
+
+	static void touch(const texture_ptr& tex_ptr);
+	static void budget(std::size_t bytes);
+	static std::size_t budget();
+	static std::size_t bytes();
+
+	static void tier_budget(std::size_t bytes);
+	static std::size_t tier_budget();
+	static std::size_t tier_bytes();
+
+	static std::size_t hits();
+	static std::size_t misses();
+
+	static statistics stats();
+	static void write_stats(std::ostream& out);
+	static sf::Time latency_bound(std::size_t bucket);
 
 private :
 
+	// Member types
+
+	//! Texture which is waiting for its image to be decoded.
+	struct pending_load {
+
+		//! Texture which holds the placeholder until the upload.
+		texture_ptr tex;
+		//! Key of the texture inside the cache.
+		std::string key;
+		//! Decoded area of the image, null if decoding failed.
+		std::future<std::shared_ptr<sf::Image>> image;
+		//! Set once the texture has been uploaded (or failed to).
+		std::promise<bool> done;
+		//! Future of the done promise, handed out to the callers.
+		std::shared_future<bool> result;
+		//! Runs since load_async() has been called.
+		sf::Clock clock;
+
+	};
+
+	//! Texture and what is needed to restore it after eviction.
+	struct texture_entry {
+
+		//! The texture itself, valid as long as the entry exists.
+		sf::Texture* tex;
+		//! Weak reference to the texture.
+		std::weak_ptr<sf::Texture> ref;
+		//! Key of the texture inside the cache, empty if not cached.
+		std::string key;
+		//! Path of the source file, empty if not loaded from a file.
+		std::string file;
+		//! Mapping of the source file, kept to restore the texture cheaply.
+		mapped_file_ptr mapping;
+		//! Area of the source file which has been loaded.
+		sf::IntRect area;
+		//! Size the area has been scaled down to, zero if not scaled.
+		sf::Vector2u size;
+		//! Pixels kept in RAM while evicted, compressed with lz_codec. Always
+		//! kept if there is no source file, otherwise only within the budget
+		//! of the compressed tier.
+		std::vector<std::uint8_t> packed;
+		//! Size of the texture the compressed pixels belong to.
+		sf::Vector2u packed_size;
+		//! Size of the texture, kept while evicted.
+		sf::Vector2u tex_size;
+		//! Bytes the texture takes up on the graphics card.
+		std::size_t bytes;
+		//! False while evicted.
+		bool resident;
+		//! True while the texture must not be evicted, e.g. pending loads.
+		bool pinned;
+		//! Tick of the last use, see m_tick.
+		std::uint64_t used;
+		//! Smooth filter of the texture, restored after eviction.
+		bool smooth;
+		//! Repeat mode of the texture, restored after eviction.
+		bool repeated;
+
+	};
+
+	//! Type of the list holding the textures.
+	typedef std::list<texture_entry> entry_list;
+
+	//! Part of the repository guarded by its own mutex.
+	struct repo_shard {
+
+		//! Guards all members of the shard.
+		std::mutex mutex;
+		//! Textures of the shard, the most recently used one first.
+		entry_list textures;
+		//! Position of each texture inside the texture list.
+		std::unordered_map<const sf::Texture*, entry_list::iterator> entries;
+		//! Maps the key of a source (see make_key()) to the texture loaded
+		//! from it. Only weak references are held, so the cache does not keep
+		//! any texture alive.
+		std::unordered_map<std::string, std::weak_ptr<sf::Texture>> cache;
+
+	};
+
+	//! Deleter of the textures created by the repository.
+	struct releaser {
+
+		//! Index of the shard holding the texture.
+		std::size_t shard;
+
+		void operator()(sf::Texture* tex) const;
+
+	};
+
+	//! Marks the end of the lifetime of the repository on destruction.
+	struct lifetime_guard {
+
+		~lifetime_guard();
+
+	};
+
+	// Member functions
+
+	static std::string make_key(const std::string& source,
+								const sf::IntRect& area,
+								const sf::Vector2u& size = sf::Vector2u());
+	static std::string hash_key(const void* data, std::size_t size);
+	static bool lookup(texture_ptr* tex_ptr, const std::string& key);
+	static bool atlas_lookup(texture_ptr* tex_ptr, sf::IntRect* rect,
+							 const std::string& key);
+	static bool store(texture_ptr* tex_ptr, const texture_ptr& tex,
+					  const std::string& key,
+					  const std::string& file = std::string(),
+					  const sf::IntRect& area = sf::IntRect(),
+					  const sf::Vector2u& size = sf::Vector2u(),
+					  bool pinned = false);
+	static void use(repo_shard& shard, entry_list::iterator entry);
+	static void count_bytes(std::size_t bytes);
+	static void count_load(const sf::Time& latency);
+	static void write_string(std::ostream& out, const std::string& text);
+
+	static std::size_t shard_index(const std::string& key);
+	static repo_shard* shard_of(const texture_ptr& tex);
+	static texture_ptr create(const std::string& key);
+	static texture_ptr create_page(unsigned int size, std::size_t index);
+	static void release(sf::Texture* tex, std::size_t shard);
+
+	static bool load_file(sf::Texture* tex, const std::string& filename,
+						  const sf::IntRect& area, const sf::Vector2u& size,
+						  const mapped_file* mapping = nullptr);
+	static sf::Image process(const sf::Image& image, const sf::IntRect& area,
+							 const sf::Vector2u& size);
+	static sf::IntRect view_rect(const sf::Vector2u& tex_size,
+								 const sf::IntRect& area);
+
+	static std::size_t tex_bytes(const sf::Texture& tex);
+	static void evict(texture_entry& entry);
+	static bool reload(texture_entry& entry);
+	static void unpack(texture_entry& entry);
+	static void shrink();
+	static std::vector<entry_list::reverse_iterator> tails();
+	static std::size_t oldest(std::vector<entry_list::reverse_iterator>* next,
+					const std::function<bool(const texture_entry&)>& candidate);
+
 	// Member variables
 
-	static std::list<texture_ptr> m_textures;
-	static std::size_t destruct_count;
+	static const std::size_t shard_count = 16;
+	static repo_shard m_shards[shard_count];
+	static std::atomic<std::size_t> m_next_shard;
+	static std::atomic<std::uint64_t> m_tick;
+
+	static std::atomic<std::size_t> m_budget;
+	static std::atomic<std::size_t> m_bytes;
+	static std::atomic<std::size_t> m_tier_budget;
+	static std::atomic<std::size_t> m_tier_bytes;
+
+	static std::atomic<std::size_t> m_peak_bytes;
+
+	static std::atomic<std::size_t> m_hits;
+	static std::atomic<std::size_t> m_misses;
+	static std::atomic<std::size_t> m_evictions;
+	static std::atomic<std::size_t> m_reloads;
+	static std::atomic<std::size_t> m_latency[latency_buckets];
+
+	static std::list<pending_load> m_pending;
+
+	static std::mutex m_atlas_mutex;
+	static texture_atlas m_atlas;
+	static std::map<std::string, std::pair<texture_ptr, sf::IntRect>>
+		m_atlas_cache;
+
+	static std::atomic<bool> m_alive;
+	static lifetime_guard m_guard;
 
 };
 
@@ -0,0 +1,86 @@
+// worker_pool - Pool of threads working off queued tasks.
+// worker_pool.hpp
+
+#ifndef _WORKERPOOL_
+#define _WORKERPOOL_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <queue>
+#include <vector>
+#include <type_traits>
+
+//! Pool of worker threads.
+/*!
+* Holds a fixed amount of threads which work off the tasks pushed into the
+* pool, in the order they were pushed. It is used to move work, which does not
+* need the render thread (like decoding images), away from it.
+*
+* ATTENTION: Tasks must not touch anything which needs an OpenGL context, e.g.
+* sf::Texture. Only do the CPU side of the work inside the pool and hand the
+* result back to the render thread.
+*/
+class worker_pool {
+
+public :
+
+	// Member functions
+
+	explicit worker_pool(std::size_t threads = 0);
+	~worker_pool();
+
+	worker_pool(const worker_pool&) = delete;
+	worker_pool& operator=(const worker_pool&) = delete;
+
+	void push(std::function<void()> task);
+
+	//! Push a task and get a future for its result.
+	/*!
+	* Wraps the callable into a task which is pushed into the pool. The result
+	* of the callable can be retrieved with the returned future.
+	* \param func Callable without arguments which should be run by the pool.
+	* \return Future holding the result of the callable.
+	*/
+	template <typename Func>
+	std::future<typename std::result_of<Func()>::type> submit(Func func) {
+
+		typedef typename std::result_of<Func()>::type result_type;
+
+		auto task = std::make_shared<std::packaged_task<result_type()>>(func);
+		auto result = task->get_future();
+		push([task]() { (*task)(); });
+
+		return result;
+
+	}
+
+	std::size_t size() const;
+
+	static worker_pool& shared();
+
+private :
+
+	// Member functions
+
+	void work();
+
+	// Member variables
+
+	//! Threads of the pool.
+	std::vector<std::thread> m_threads;
+	//! Tasks which are not yet picked up by a thread.
+	std::queue<std::function<void()>> m_tasks;
+	//! Mutex guarding the task queue and the stop flag.
+	std::mutex m_mutex;
+	//! Signals the threads that a task has been pushed or the pool stops.
+	std::condition_variable m_cond;
+	//! True once the pool is destructed.
+	bool m_stop;
+
+};
+
+#endif // _WORKERPOOL_
@@ -2,6 +2,10 @@
 
 #include "Orion.hpp"
 #include <iostream>
+#include <algorithm>
+
+//! Longest sleep of the main loop, keeps input and the clock text responsive.
+static const sf::Time max_idle = sf::milliseconds(16);
 
 //! Value constructor.
 /*!
@@ -14,7 +18,7 @@
 Orion::Orion(sf::VideoMode mode, const sf::String& title , sf::Uint32 style ,
 			 const sf::ContextSettings& settings) : 
 m_win(mode, title, style, settings), m_win_icon(), m_time_str(), m_background(),
-m_wymon(), m_clock(), m_elap_time(), m_font(), m_time_text(), m_date_text(), 
+m_wymon(), m_clock(), m_font(), m_time_text(), m_date_text(), 
 m_textfield(&m_font) {
 }
 
@@ -47,6 +51,20 @@ bool Orion::win_icon(const std::string& filename) {
 	
 }
 
+//! Set window icon from an image.
+/*!
+* Same as win_icon(const std::string&), but takes an already loaded image.
+* \param icon Graphic that should be the window's icon.
+*/
+void Orion::win_icon(const sf::Image& icon) {
+
+	m_win_icon = icon;
+
+	auto icon_size = m_win_icon.getSize();
+	m_win.setIcon(icon_size.x, icon_size.y, m_win_icon.getPixelsPtr());
+
+}
+
 //! Set the position of the objects.
 /*!
 * Set the position of all graphical objects on the screen.
@@ -96,6 +114,19 @@ void Orion::obj_pos() {
 
 }
 
+//! Fit the background to the desktop.
+/*!
+* Scales the background so it fits the maximum desktop size.
+*/
+void Orion::fit_bg() {
+
+	auto max_win_size = sf::VideoMode::getDesktopMode();
+	auto background_size = m_background.obj_size();
+	m_background.setScale(sf::Vector2f(max_win_size.width / background_size.x,
+						  max_win_size.height / background_size.y));
+
+}
+
 //! Render all objects.
 /*!
 * Updates and renders all objects that change with time.
@@ -117,16 +148,9 @@ void Orion::render() {
 
 	}
 
-	// Animate m_wymon animation.
-	// Update elapsed time and check if limit is reached. If yes, render frame
-	// and restart the clock.
-	m_elap_time = m_clock.getElapsedTime();
-	if (850.f <= m_elap_time.asMilliseconds()) {
-	
-		m_wymon.render();
-		m_clock.restart();
-	
-	}
+	// Animate m_wymon animation, it shows the frame which is due after the
+	// time passed since the last call.
+	m_wymon.update(m_clock.restart());
 
 	draw_obj();
 
@@ -209,40 +233,82 @@ void Orion::run() {
 	// Clear the window in case something is already in there.
 	m_win.clear(); 
 
-	// Font.
-	if (!m_font.loadFromFile("res/NotoSerif-Regular.ttf")) {
+	// Keep the decoded images, so the next start does not decode them again.
+	texture_bake::dir("res/baked");
+
+	// Load all resources at the same time, see res/manifest.txt.
+	preloader assets;
+	if (!assets.manifest("res/manifest.txt") || !assets.load()) {
 	
-		std::cerr << "Could not load Noto font\n";
+		std::cerr << "Could not load resources\n";
 		std::cin.get();
 		return;
 	
 	}
 
+	auto font = assets.find("font");
+	auto icon = assets.find("icon");
+	auto background = assets.find("background");
+	auto wymon = assets.find("wymon");
+
+	if (!font || !icon || !background || !wymon) {
+	
+		std::cerr << "Resources missing in res/manifest.txt\n";
+		std::cin.get();
+		return;
+	
+	}
+
+	// Window icon.
+	win_icon(*icon->image);
+
+	// Font.
+	m_font = *font->font;
+
 	// Background.
-	if (!m_background.load("res/background.jpg")) {
+	// The texture has already been uploaded by the preloader, so this is
+	// served by the cache. Since it is never drawn bigger than the desktop, it
+	// is stored at that size instead of the size of the file.
+	if (!m_background.load(background->path, sf::IntRect(), background->area,
+						   background->size)) {
 	
-		std::cerr << "Could not load background.jpg\n";
+		std::cerr << "Could not load " << background->path << "\n";
 		std::cin.get();
 		return;
 	
 	}
-	// Scale background so it fits the maximum desktop size.
-	auto max_win_size = sf::VideoMode::getDesktopMode();
-	auto background_size = m_background.obj_size();
-	m_background.setScale(sf::Vector2f(max_win_size.width / background_size.x,
-						  max_win_size.height / background_size.y));
+
+	fit_bg();
 	m_win.draw(m_background);
 
 	// Wymon animation.
-	if (!m_wymon.load("res/wymon.png", sf::IntRect(0, 0, 106, 96))) {
+	// The frame layout is stored next to the sprite sheet, with the same name
+	// but the extension ".sheet", see sprite_sheet.
+	sprite_sheet wymon_sheet;
+	auto sheet_path = wymon->path.substr(0, wymon->path.rfind('.')) + ".sheet";
+
+	if (!wymon_sheet.load(sheet_path) || wymon_sheet.frames().empty()) {
+	
+		std::cerr << "Could not load " << sheet_path << "\n";
+		std::cin.get();
+		return;
 	
-		std::cerr << "Could not load wymon.png\n";
+	}
+
+	// Small sprite sheet, so it is shared with the other small images.
+	auto& first_frm = wymon_sheet.frames().front();
+	if (!m_wymon.load_atlas(wymon->path,
+							sf::IntRect(0, 0, first_frm.w, first_frm.h),
+							wymon->area)) {
+	
+		std::cerr << "Could not load " << wymon->path << "\n";
 		std::cin.get();
 		return;
 	
 	}
-	m_wymon.insert(frame(0, 0, 106, 96));
-	m_wymon.insert(frame(107, 0, 108, 96));
+
+	m_wymon.insert(wymon_sheet.frames(), 0);
+	m_wymon.durations(wymon_sheet.durations());
 	m_win.draw(m_wymon);
 
 	// Textfield
@@ -264,10 +330,13 @@ void Orion::run() {
 	// First display of all objects.
 	m_win.display();
 
+	assets.first_frame();
+	assets.report(std::clog);
+
 	obj_pos();
 
-	// Initialize the elapsed time variable.
-	m_elap_time = m_clock.restart();
+	// Start the animation clock.
+	m_clock.restart();
 
 	// Main loop.
 	while (m_win.isOpen()) {
@@ -275,6 +344,11 @@ void Orion::run() {
 		// Event loop.
 		proc_events();
 		render();
+
+		// Sleep until the animation shows the next frame. SFML can not wait
+		// for events with a timeout, so wake up often enough for input and the
+		// clock text anyway.
+		sf::sleep(std::min(m_wymon.next_deadline(), max_idle));
 		
 	}
 
@@ -5,6 +5,9 @@
 #include <cmath>
 #include <iostream>
 
+//! Duration of frames, if neither the frame nor the animation sets one.
+static const sf::Time default_frame_time = sf::milliseconds(100);
+
 /* 
 * ATTENTION: The function "calc_max_size()" uses the "std::isless()" function to
 * compare to floating point variables. Since normal comparison can cause a lot
@@ -20,11 +23,12 @@
 * Creates an empty animation with no source texture. Additionally, it reserves
 * space for internal vector holding pointers to the frames.
 */
-animation::animation() : m_max_size() {
+animation::animation() : m_max_size(), m_frame_time(default_frame_time),
+						 m_elapsed() {
 
     m_texture = nullptr;
 
-    m_frames = nullptr;
+    m_frames = NO_FRM;
     frame_repository::create(&m_frames);
 
 	mTexRect = sf::IntRect();
@@ -44,19 +48,20 @@ animation::animation() : m_max_size() {
 * Constructs animation with given texture.
 * \param texture Texture which will be used for the animation.
 */
-animation::animation(const sf::Texture& texture) : m_max_size() {
+animation::animation(const sf::Texture& texture) : m_max_size(),
+					 m_frame_time(default_frame_time), m_elapsed() {
 
     m_texture = nullptr;
 
-    m_frames = nullptr;
+    m_frames = NO_FRM;
     frame_repository::create(&m_frames);
 
-	mTexRect = sf::IntRect();
-	setTexture(texture);
-
     // Refer to default constructor for explenation.
 	m_index = -1;
 
+	mTexRect = sf::IntRect();
+	setTexture(texture);
+
 }
 
 //! Texture constructor with texture rectangle.
@@ -67,26 +72,69 @@ animation::animation(const sf::Texture& texture) : m_max_size() {
 * \param rect Texture rectangle for displayed part of animation.
 */
 animation::animation(const sf::Texture& texture, const sf::IntRect& rect) : 
-					 m_max_size() {
+					 m_max_size(), m_frame_time(default_frame_time),
+					 m_elapsed() {
 
     m_texture = nullptr;
-    setTexture(texture);
 
-    m_frames = nullptr;
+    m_frames = NO_FRM;
     frame_repository::create(&m_frames);
 
+	// Refer to default constructor for explenation.
+	m_index = -1;
+
+	// The frames have to exist first, setting the texture updates them.
 	mTexRect = sf::IntRect();
+	setTexture(texture);
 	setTexRect(rect);
 
-	// Refer to default constructor for explenation.
-	m_index = -1;
+}
+
+//! Copy constructor.
+/*!
+* Constructs animation which shares the frames of the other animation, until
+* one of them changes its frames, see frame_repository::edit().
+* \param other Animation from which to copy construct.
+*/
+animation::animation(const animation& other) : Textureable(other),
+					 m_frames(other.m_frames), m_index(other.m_index),
+					 m_max_size(other.m_max_size),
+					 m_frame_time(other.m_frame_time),
+					 m_elapsed(other.m_elapsed) {
+
+	frame_repository::acquire(m_frames);
 
 }
 
 //! Default destructor.
 animation::~animation() {
 
-    frame_repository::tidy();
+    frame_repository::release(&m_frames);
+
+}
+
+//! Copy assignment.
+/*!
+* Shares the frames of the other animation, until one of them changes its
+* frames, and releases the own ones.
+* \param other Animation from which to copy.
+* \return This animation.
+*/
+animation& animation::operator=(const animation& other) {
+
+	// Acquire first, so assigning an animation to itself keeps its frames.
+	auto frames = other.m_frames;
+	frame_repository::acquire(frames);
+	frame_repository::release(&m_frames);
+
+	Textureable::operator=(other);
+	m_frames = frames;
+	m_index = other.m_index;
+	m_max_size = other.m_max_size;
+	m_frame_time = other.m_frame_time;
+	m_elapsed = other.m_elapsed;
+
+	return *this;
 
 }
 
@@ -99,7 +147,7 @@ animation::~animation() {
 */
 std::size_t animation::insert(const frame& frm, sf::IntRect rect) {
 
-	calc_max_size(sf::Vector2f(frm.w, frm.h));
+	calc_max_size(sf::Vector2f(frm.logical_size()));
 
     // If no textre rectangle is given, use internal.
     if (sf::IntRect() == rect) {
@@ -120,8 +168,9 @@ std::size_t animation::insert(const frame& frm, sf::IntRect rect) {
 *
 * ATTENTION: No range checking for index.
 *
-* ATTENTION: Use with caution, because this function is linear in the size of
-* the index, O(index), so it may slow down the program if index is large.
+* ATTENTION: Use with caution, because all frames behind the index are moved,
+* so it may slow down the program if there are many of them. Insert several
+* frames at once with the bulk insert.
 * \param frm Frame to be inserted at the end of the animation.
 * \param index Index where to insert the frame.
 * \param rect Optional texture rectangle for animation frame.
@@ -130,7 +179,7 @@ std::size_t animation::insert(const frame& frm, sf::IntRect rect) {
 std::size_t animation::insert(const frame& frm, std::size_t index,
                               sf::IntRect rect) {
 
-	calc_max_size(sf::Vector2f(frm.w, frm.h));
+	calc_max_size(sf::Vector2f(frm.logical_size()));
 
     // If no textre rectangle is given, use internal.
     if (sf::IntRect() == rect) {
@@ -145,56 +194,46 @@ std::size_t animation::insert(const frame& frm, std::size_t index,
 
 }
 
-//! Insert frames inside frame group at end.
+//! Insert frames at given position.
 /*!
-* Calculates frames which are inside the frame group and stores them at the end
-* of the frame storing structure.
-* \param frm_grp Frame group holding all frames which should be inserted.
-* \param rect Texture rectangle which is applied to the frames.
-* \return Index position of the first inserted frame of the group.
+* Inserts several frames at the index position of the animation, in their
+* order. The frames behind the index are moved only once for all of them.
+*
+* ATTENTION: No range checking for index.
+* \param frms Frames to be inserted.
+* \param index Index where to insert the first frame.
+* \param rect Optional texture rectangle for the animation frames.
+* \return Index (position) where the first frame has been inserted (returns
+* index).
 */
-std::size_t animation::insert(const frame_group& frm_grp, sf::IntRect rect) {
-
-    // If no textre rectangle is given, use internal.
-    auto temp_tex_rect = ((sf::IntRect() == rect) ? mTexRect : rect);
-
-    // Calculate how many rows and colums are inside the frame group.
-    std::size_t rows = frm_grp.sh / frm_grp.h;
-    std::size_t cols = frm_grp.sw / frm_grp.w;
-
-    // Index of the first frame of the frame group which is inserted.
-    // Will have an offset of the number of inserted frames, which is basically
-    // rows * cols.
-    std::size_t index{};
-
-    // Calculate and iterate through the frames inside the group.
-    for (std::size_t i = 0; i < rows; ++ i) {
+std::size_t animation::insert(const std::vector<frame>& frms, std::size_t index,
+                              sf::IntRect rect) {
 
-        for (std::size_t j = 0; j < cols; ++ j) {
+	for (auto& frm : frms) {
 
-            // Create temporary frame based on the current row and column.
-            auto temp_frame = frame(frm_grp.x + j * frm_grp.w,
-                                    frm_grp.y + i * frm_grp.h,
-                                    frm_grp.w, frm_grp.h);
+		calc_max_size(sf::Vector2f(frm.logical_size()));
 
-			calc_max_size(sf::Vector2f(temp_frame.w, temp_frame.h));
+	}
 
-			/*std::cout << "Now inserting frame with values: " << std::endl;
-			std::cout << "\tx = " << temp_frame.x << std::endl;
-			std::cout << "\ty = " << temp_frame.y << std::endl;
-			std::cout << "\tw = " << temp_frame.w << std::endl;
-			std::cout << "\th = " << temp_frame.h << std::endl;
-			std::cin.get();*/
+    // If no textre rectangle is given, use internal.
+    auto temp_tex_rect = ((sf::IntRect() == rect) ? mTexRect : rect);
 
-            index = frame_repository::insert(&m_frames, temp_frame,
-                                             temp_tex_rect);
+    return frame_repository::insert(&m_frames, frms.data(), frms.size(), index,
+                                    temp_tex_rect);
 
-        }
+}
 
-    }
+//! Insert frames inside frame group at end.
+/*!
+* Calculates frames which are inside the frame group and stores them at the end
+* of the frame storing structure.
+* \param frm_grp Frame group holding all frames which should be inserted.
+* \param rect Texture rectangle which is applied to the frames.
+* \return Index position of the first inserted frame of the group.
+*/
+std::size_t animation::insert(const frame_group& frm_grp, sf::IntRect rect) {
 
-    // Remove offset before returning.
-    return (index - rows * cols);
+    return insert(split(frm_grp), frames(), rect);
 
 }
 
@@ -204,9 +243,6 @@ std::size_t animation::insert(const frame_group& frm_grp, sf::IntRect rect) {
 * given position inside the frame storing structure.
 *
 * ATTENTION: No range checking for index.
-*
-* ATTENTION: Use with caution, because this function is linear in the size of
-* the index, O(index), so it may slow down the program if index is large.
 * \param frm_grp Frame group holding all frames which should be inserted.
 * \param index Index where to insert the first frame of the group.
 * \param rect Texture rectangle which is applied to the frames.
@@ -215,39 +251,31 @@ std::size_t animation::insert(const frame_group& frm_grp, sf::IntRect rect) {
 std::size_t animation::insert(const frame_group& frm_grp, std::size_t index,
                               sf::IntRect rect) {
 
-    // If no textre rectangle is given, use internal.
-    auto temp_tex_rect = ((sf::IntRect() == rect) ? mTexRect : rect);
+    return insert(split(frm_grp), index, rect);
 
-    // Calculate how many rows and colums are inside the frame group.
-    std::size_t rows = frm_grp.sh / frm_grp.h;
-    std::size_t cols = frm_grp.sw / frm_grp.w;
-
-    // Save index so it can be returned later.
-    auto first_index = index;
-
-    // Calculate and iterate through the frames inside the group.
-    for (std::size_t i = 0; i < rows; ++ i) {
-
-        for (std::size_t j = 0; j < cols; ++ j) {
-
-            // Create temporary frame based on the current row and column.
-            auto temp_frame = frame(frm_grp.x + j * frm_grp.w,
-                                    frm_grp.y + i * frm_grp.h,
-                                    frm_grp.w, frm_grp.h);
-			
-			calc_max_size(sf::Vector2f(temp_frame.w, temp_frame.h));
-
-            index = frame_repository::insert(&m_frames, temp_frame,
-                                             index, temp_tex_rect);
+}
 
-            // Increase index for every frames so they are added consecutively.
-            ++ index;
+//! Share frames stored by someone else.
+/*!
+* Releases the frames of the animation and uses the given ones instead.
+* \param frames Handle of the frames, is acquired.
+* \param rect Texture rectangle which has been applied to the frames.
+* \param max_size Biggest size of the frames.
+*/
+void animation::bind(frames_handle frames, const sf::IntRect& rect,
+					 const sf::Vector2f& max_size) {
 
-        }
+	// Acquire first, the animation may already use the frames.
+	frame_repository::acquire(frames);
+	frame_repository::release(&m_frames);
 
-    }
+	m_frames = frames;
+	mTexRect = rect;
+	m_max_size = max_size;
 
-    return first_index;
+	// Refer to default constructor for explenation.
+	m_index = -1;
+	m_elapsed = sf::Time::Zero;
 
 }
 
@@ -266,8 +294,10 @@ void animation::setTexRect(const sf::IntRect& rect)
 
         mTexRect = rect ;
 		frame_repository::apply_tex_rect(&m_frames, mTexRect);
-        updatePos() ;
-        updateTexCoords() ;
+
+		// Positions and texture coordinates have to come from the same quad,
+		// a trimmed frame only covers a part of its logical frame.
+        show_frame() ;
 
     }
 
@@ -283,8 +313,10 @@ void animation::setTexRect(const sf::IntRect& rect)
 */
 void animation::replace(std::size_t index, const frame& other) {
 
+	auto& frames = frame_repository::edit(&m_frames);
+
 	// Change the original frame and calculate new texture frame.
-	m_frames->operator[](ORIG_FRM).operator[](index) = other;
+	frames[ORIG_FRM].set(index, other);
 	
 	// Frame with applied texture rectangle.
 	frame tmp_frm;
@@ -301,9 +333,9 @@ void animation::replace(std::size_t index, const frame& other) {
 	
 	}
 
-	calc_max_size(sf::Vector2f(tmp_frm.w, tmp_frm.h));
+	calc_max_size(sf::Vector2f(tmp_frm.logical_size()));
 
-	m_frames->operator[](TEX_RECT_FRM).operator[](index)  = tmp_frm;
+	frames[TEX_RECT_FRM].set(index, tmp_frm);
 
 }
 
@@ -315,13 +347,13 @@ void animation::replace(std::size_t index, const frame& other) {
 */
 void animation::mod_size(std::size_t index, const sf::Vector2i& size) {
 
-	m_frames->operator[](ORIG_FRM).operator[](index).w = size.x;
-	m_frames->operator[](ORIG_FRM).operator[](index).h = size.y;
+	auto& frames = frame_repository::edit(&m_frames);
+
+	frames[ORIG_FRM].w[index] = size.x;
+	frames[ORIG_FRM].h[index] = size.y;
 
-	// Save current frame.
-	auto cur_frm = m_frames->operator[](TEX_RECT_FRM).operator[](index);
-	cur_frm.w = size.x;
-	cur_frm.h = size.y;
+	// Clip the original frame, the current one has been clipped already.
+	auto cur_frm = frames[ORIG_FRM][index];
 	frame new_frm;
 	
 	// If no texture rectangle is given, use plain frame; if one is given,
@@ -336,9 +368,9 @@ void animation::mod_size(std::size_t index, const sf::Vector2i& size) {
 	
 	}
 
-	calc_max_size(sf::Vector2f(new_frm.w, new_frm.h));
+	calc_max_size(sf::Vector2f(new_frm.logical_size()));
 
-	m_frames->operator[](TEX_RECT_FRM).operator[](index) = new_frm;
+	frames[TEX_RECT_FRM].set(index, new_frm);
 
 }
 
@@ -350,15 +382,24 @@ void animation::mod_size(std::size_t index, const sf::Vector2i& size) {
 */
 void animation::mod_pos(std::size_t index, const sf::Vector2i& pos) {
 
-	m_frames->operator[](ORIG_FRM).operator[](index).x = pos.x;
-	m_frames->operator[](ORIG_FRM).operator[](index).y = pos.y;
+	auto& frames = frame_repository::edit(&m_frames);
+
+	frames[ORIG_FRM].x[index] = pos.x;
+	frames[ORIG_FRM].y[index] = pos.y;
 
-	// The position of a frame within the sprite sheet is not taken into
-	// account when the intersection of a frame and the texture rectangle is
-	// calculated, thus no new intersection calculation is needed. The values
-	// can be overwritten.
-	m_frames->operator[](TEX_RECT_FRM).operator[](index).x = pos.x;
-	m_frames->operator[](TEX_RECT_FRM).operator[](index).y = pos.y;
+	// A clipped trimmed frame starts behind the part which is clipped off by
+	// the texture rectangle, so calculate the intersection again.
+	if (sf::IntRect() == mTexRect) {
+
+		frames[TEX_RECT_FRM].x[index] = pos.x;
+		frames[TEX_RECT_FRM].y[index] = pos.y;
+
+	} else {
+
+		frames[TEX_RECT_FRM].set(index, frame_repository::intersect(
+								 frames[ORIG_FRM][index], mTexRect));
+
+	}
 
 }
 
@@ -369,8 +410,11 @@ void animation::mod_pos(std::size_t index, const sf::Vector2i& pos) {
 */
 std::size_t animation::render() {
 
+	// Share the frames with identical animations, once they are complete.
+	frame_repository::intern(&m_frames);
+
     // Check if already last frame.
-    if ((m_frames->operator[](TEX_RECT_FRM).size() - 1) == m_index) {
+    if ((frame_repository::size(m_frames) - 1) == m_index) {
 
         m_index = 0;
 
@@ -382,8 +426,9 @@ std::size_t animation::render() {
 
 	//std::cout << "Currently rendering frame " << m_index << std::endl;
 
-    updatePos();
-    updateTexCoords();
+	// The new frame starts its full duration, see update().
+	m_elapsed = sf::Time::Zero;
+    show_frame();
 
     return m_index;
 
@@ -397,14 +442,167 @@ std::size_t animation::render() {
 */
 std::size_t animation::render(std::size_t index) {
 
+	frame_repository::intern(&m_frames);
+
     m_index = index;
-    updatePos();
-    updateTexCoords();
+	m_elapsed = sf::Time::Zero;
+    show_frame();
 
     return m_index;
 
 }
 
+//! Set the default frame duration.
+/*!
+* Used for all frames without an own duration, see durations().
+* \param time Time a frame is shown, ignored if not positive.
+*/
+void animation::frame_time(sf::Time time) {
+
+	if (sf::Time::Zero < time) {
+
+		m_frame_time = time;
+
+	}
+
+}
+
+//! Get the default frame duration.
+/*!
+* \return Time a frame without an own duration is shown.
+*/
+sf::Time animation::frame_time() const {
+
+	return m_frame_time;
+
+}
+
+//! Set the durations of frames.
+/*!
+* A duration of zero (or less) means the default frame duration, see
+* frame_time(). Like the frames, the durations are shared with identical
+* animations.
+*
+* ATTENTION: No range checking is done, the frames from index to
+* index + times.size() - 1 have to exist.
+* \param times Time each frame is shown, e.g. sprite_sheet::durations().
+* \param index Index of the frame which gets the first duration.
+*/
+void animation::durations(const std::vector<sf::Time>& times,
+						  std::size_t index) {
+
+	if (times.empty()) {
+
+		return;
+
+	}
+
+	frame_repository::set_durations(&m_frames, times.data(), times.size(),
+									index);
+
+}
+
+//! Advance the animation by time.
+/*!
+* Adds the time to the time the current frame has been shown and moves on to
+* the frame which has to be shown now. If the program stalled for longer than
+* a frame, the frames in between are skipped, so the animation keeps its speed.
+* Once a whole cycle has passed, the rest is reduced by the cycle length, so a
+* long stall costs at most two cycles of steps.
+*
+* The first call starts the animation with the first frame and ignores the
+* time. The frame is only shown again if it changed.
+* \param dt Time passed since the last call, negative times count as zero.
+* \return Index of the current frame.
+*/
+std::size_t animation::update(sf::Time dt) {
+
+	frame_repository::intern(&m_frames);
+
+	auto count = frame_repository::size(m_frames);
+
+	if (0 == count) {
+
+		return m_index;
+
+	}
+
+	auto index = m_index;
+
+	// Not yet started (see default constructor) or frames have been removed.
+	if (count <= index) {
+
+		index = 0;
+		m_elapsed = sf::Time::Zero;
+
+	} else if (sf::Time::Zero < dt) {
+
+		m_elapsed += dt;
+
+	}
+
+	sf::Time cycle;
+	std::size_t steps = 0;
+
+	for (auto shown = shown_for(index); shown <= m_elapsed;
+		 shown = shown_for(index)) {
+
+		m_elapsed -= shown;
+		cycle += shown;
+		index = (index + 1) % count;
+
+		// Back at the frame of the cycle start, the rest of the time is
+		// shorter than a cycle afterwards. All durations are positive, so the
+		// cycle is too.
+		if (count == ++ steps) {
+
+			m_elapsed = sf::microseconds(m_elapsed.asMicroseconds() %
+										 cycle.asMicroseconds());
+			cycle = sf::Time::Zero;
+			steps = 0;
+
+		}
+
+	}
+
+	if (index != m_index) {
+
+		m_index = index;
+		show_frame();
+
+	}
+
+	return m_index;
+
+}
+
+//! Get the time until the frame changes.
+/*!
+* Lets the main loop sleep until the next call of update() has something to
+* do.
+* \return Time until the next frame has to be shown, zero if the animation has
+* not been started by update() yet.
+*/
+sf::Time animation::next_deadline() const {
+
+	auto count = frame_repository::size(m_frames);
+
+	if (0 == count) {
+
+		return m_frame_time;
+
+	}
+
+	if (count <= m_index) {
+
+		return sf::Time::Zero;
+
+	}
+
+	return shown_for(m_index) - m_elapsed;
+
+}
+
 //! Get the local boundaries rectangle.
 /*!
 * The returned rectangle is in local coordinates. This means that
@@ -421,7 +619,7 @@ sf::FloatRect animation::loc_bound() const {
 
 	// If frame list is empty, use texture rectangle, if not, use the current
 	// frame.
-	if (0 == m_frames->operator[](ORIG_FRM).size()) {
+	if (0 == frame_repository::size(m_frames)) {
 	
 		//std::cout << "Local boundaries from mTexRect";
 		width = static_cast<float>(std::abs(mTexRect.width));
@@ -446,7 +644,7 @@ sf::FloatRect animation::loc_bound() const {
 		// currently drawn frame (by this I mean the frame that gets drawn on
 		// the screen with the next call of "draw()".
 		std::size_t temp_index{};
-		if (m_frames->operator[](ORIG_FRM).size() <= m_index) {
+		if (frame_repository::size(m_frames) <= m_index) {
 		
 			temp_index = 0;
 		
@@ -456,13 +654,14 @@ sf::FloatRect animation::loc_bound() const {
 		
 		}
 	
-		auto tex_frm = 
-		m_frames->operator[](TEX_RECT_FRM).operator[](temp_index);
+		// Trimmed frames take up the size of their logical frame.
+		auto tex_frm = frame_repository::clipped(m_frames, temp_index);
+		auto tex_size = tex_frm.logical_size();
 
 		/*std::cout << "Local boundaries from TEX_RECT_FRM\n";
 		std::cout << "Index is at position " << m_index;*/
-    	width = static_cast<float>(std::abs(tex_frm.w)) ;
-    	height = static_cast<float>(std::abs(tex_frm.h)) ;
+    	width = static_cast<float>(tex_size.x) ;
+    	height = static_cast<float>(tex_size.y) ;
 
 		/*std::cout << "\nFrame boundaries: \n";
 		std::cout << "\t width = " << width << "\n";
@@ -519,7 +718,7 @@ sf::Vector2f animation::max_size() {
 */
 std::size_t animation::frames() {
 
-	return m_frames->operator[](ORIG_FRM).size();
+	return frame_repository::size(m_frames);
 
 }
 
@@ -553,6 +752,84 @@ void animation::calc_max_size(const sf::Vector2f& size) {
 
 }
 
+//! Get the duration of a frame.
+/*!
+* \param index Index of the frame, no range checking.
+* \return Time the frame is shown, the default frame duration if it has none.
+*/
+sf::Time animation::shown_for(std::size_t index) const {
+
+	auto time = frame_repository::duration(m_frames, index);
+
+	return (sf::Time::Zero < time) ? time : m_frame_time;
+
+}
+
+//! Split frame group into frames.
+/*!
+* \param frm_grp Frame group to split.
+* \return Frames inside the frame group, row by row.
+*/
+std::vector<frame> animation::split(const frame_group& frm_grp) {
+
+    // Calculate how many rows and colums are inside the frame group.
+    std::size_t rows = frm_grp.sh / frm_grp.h;
+    std::size_t cols = frm_grp.sw / frm_grp.w;
+
+    std::vector<frame> frms;
+    frms.reserve(rows * cols);
+
+    // Calculate and iterate through the frames inside the group.
+    for (std::size_t i = 0; i < rows; ++ i) {
+
+        for (std::size_t j = 0; j < cols; ++ j) {
+
+            frms.push_back(frame(frm_grp.x + j * frm_grp.w,
+                                 frm_grp.y + i * frm_grp.h,
+                                 frm_grp.w, frm_grp.h));
+
+        }
+
+    }
+
+    return frms;
+
+}
+
+//! Update the vertices to the current frame.
+/*!
+* Copies the precomputed quad of the current frame into the vertices, see
+* frame_repository::quad(), and moves its texture coordinates to the area of
+* the texture holding the image. Without frames, the vertices are calculated
+* from the texture rectangle. Before the first frame is rendered, the first
+* frame is shown.
+*/
+void animation::show_frame() {
+
+	if (0 == frame_repository::size(m_frames)) {
+
+		updatePos();
+		updateTexCoords();
+		return;
+
+	}
+
+	// Before the first frame is rendered, the index is still out of range
+	// (see loc_bound()), so use the frame which is rendered first.
+	auto index = (frame_repository::size(m_frames) <= m_index) ? 0 : m_index;
+	auto& quad = frame_repository::quad(m_frames, index);
+	auto offset = sf::Vector2f(static_cast<float>(m_tex_area.left),
+							   static_cast<float>(m_tex_area.top));
+
+	for (std::size_t i = 0; i < 4; ++ i) {
+
+		m_vertices[i].position = quad.position[i];
+		m_vertices[i].texCoords = quad.tex_coords[i] + offset;
+
+	}
+
+}
+
 //! Update the vertices' texture coordinates.
 /*!
 * The coordinates are retrieved by the current frame and
@@ -570,7 +847,7 @@ void animation::updateTexCoords() {
 	// Check if there are already frames for the animation. If not, then the
 	// texture coords should be set to the texture rectangle, as it is done in
 	// the sprite class.
-	if (m_frames->operator[](TEX_RECT_FRM).size() == 0) {
+	if (frame_repository::size(m_frames) == 0) {
 	
 		left = static_cast<float>(mTexRect.left);
     	right = left + mTexRect.width;
@@ -579,13 +856,24 @@ void animation::updateTexCoords() {
 
 	} else {
 
-		left = static_cast<float>(m_frames->operator[](TEX_RECT_FRM).operator[](m_index).x);
-		right = left + m_frames->operator[](TEX_RECT_FRM).operator[](m_index).w;
-		top = static_cast<float>(m_frames->operator[](TEX_RECT_FRM).operator[](m_index).y);
-		bottom = top + m_frames->operator[](TEX_RECT_FRM).operator[](m_index).h;
+		// Before the first frame is rendered, the index is still out of range
+		// (see loc_bound()), so use the frame which is rendered first.
+		auto index = (frame_repository::size(m_frames) <= m_index) ?
+					 0 : m_index;
+		auto tex_frm = frame_repository::clipped(m_frames, index);
+		left = static_cast<float>(tex_frm.x);
+		right = left + tex_frm.w;
+		top = static_cast<float>(tex_frm.y);
+		bottom = top + tex_frm.h;
 
 	}
 
+	// The frames are relative to the area of the texture holding the image.
+	left += m_tex_area.left;
+	right += m_tex_area.left;
+	top += m_tex_area.top;
+	bottom += m_tex_area.top;
+
 	/*std::cout << "Frame left = " << left << std::endl;
 	std::cout << "Frame top = " << top << std::endl;
 	std::cout << "Frame right = " << right << std::endl;
@@ -610,6 +898,9 @@ void animation::draw(sf::RenderTarget& target, sf::RenderStates states) const {
 
     if (nullptr != m_texture) {
 
+        // Restores the texture if it has been evicted.
+        texture_repository::touch(m_texture);
+
         states.transform *= getTransform();
         states.texture = m_texture.get();
         target.draw(m_vertices, 4, sf::Quads, states);
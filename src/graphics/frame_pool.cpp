@@ -0,0 +1,155 @@
+// frame_pool.cpp
+
+#include "frame_pool.hpp"
+
+// Member variables
+
+//! Size of the smallest size class.
+const std::size_t frame_pool::min_block;
+
+//! Number of size classes.
+const std::size_t frame_pool::classes;
+
+//! Size of a slab, the size of the biggest size class.
+const std::size_t frame_pool::slab_size;
+
+//! Free list of each size class.
+/*!
+* The first bytes of a free block hold the pointer to the next free block of
+* its class.
+*/
+void* frame_pool::m_free[frame_pool::classes];
+
+//! Allocation counters.
+frame_pool::statistics frame_pool::m_stats;
+
+// Member functions
+
+//! Get a block of memory.
+/*!
+* Takes a block from the free list of the size class of the request, and cuts
+* a new slab into blocks if the list is empty. Requests bigger than the biggest
+* size class are passed to the system allocator.
+* \param bytes Size of the block.
+* \return Block of at least the requested size, aligned like operator new.
+*/
+void* frame_pool::allocate(std::size_t bytes) {
+
+	++ m_stats.requests;
+
+	auto block_class = size_class(bytes);
+
+	if (classes <= block_class) {
+
+		++ m_stats.system;
+		m_stats.in_use += bytes;
+
+		return ::operator new(bytes);
+
+	}
+
+	if (nullptr == m_free[block_class]) {
+
+		refill(block_class);
+
+	}
+
+	auto block = m_free[block_class];
+	m_free[block_class] = *static_cast<void**>(block);
+	m_stats.in_use += min_block << block_class;
+
+	return block;
+
+}
+
+//! Give a block of memory back.
+/*!
+* \param block Block returned by allocate(), may be null.
+* \param bytes Size passed to allocate().
+*/
+void frame_pool::deallocate(void* block, std::size_t bytes) {
+
+	if (nullptr == block) {
+
+		return;
+
+	}
+
+	auto block_class = size_class(bytes);
+
+	if (classes <= block_class) {
+
+		m_stats.in_use -= bytes;
+		::operator delete(block);
+		return;
+
+	}
+
+	*static_cast<void**>(block) = m_free[block_class];
+	m_free[block_class] = block;
+	m_stats.in_use -= min_block << block_class;
+
+}
+
+//! Get the allocation counters.
+/*!
+* \return Allocation counters since the start of the program.
+*/
+frame_pool::statistics frame_pool::stats() {
+
+	return m_stats;
+
+}
+
+//! Get the number of requests.
+/*!
+* \return Number of blocks requested since the start of the program.
+*/
+std::size_t frame_pool::requests() {
+
+	return m_stats.requests;
+
+}
+
+//! Find the size class of a request.
+/*!
+* \param bytes Size of the request.
+* \return Index of the smallest size class the request fits into, classes if
+* it is bigger than all of them.
+*/
+std::size_t frame_pool::size_class(std::size_t bytes) {
+
+	std::size_t block_class = 0;
+
+	while (block_class < classes && (min_block << block_class) < bytes) {
+
+		++ block_class;
+
+	}
+
+	return block_class;
+
+}
+
+//! Cut a new slab into blocks.
+/*!
+* \param block_class Size class of the blocks, its free list has to be empty.
+*/
+void frame_pool::refill(std::size_t block_class) {
+
+	auto block_size = min_block << block_class;
+	auto slab = static_cast<char*>(::operator new(slab_size));
+
+	++ m_stats.system;
+	m_stats.slab_bytes += slab_size;
+
+	// Link the blocks from the back, so they are handed out in order.
+	for (auto offset = slab_size; block_size <= offset; ) {
+
+		offset -= block_size;
+		*reinterpret_cast<void**>(slab + offset) = m_free[block_class];
+		m_free[block_class] = slab + offset;
+
+	}
+
+}
@@ -2,55 +2,359 @@
 
 #include "frame_repos.hpp"
 #include <iostream>
+#include <algorithm>
+#include <cstdlib>
 #include <cassert>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 // Member variables
 
-// ATTENTION: Do NOT change the "operator[]()" calls to just "[]". Implicit
-// calls to the overloaded operator generates compiler errors.
-
-//! List holding all frames.
+//! Slots holding all frames.
 /*!
-* At first, it should be an empty list.
+* At first, there should be no slots. Slots are never removed, released ones
+* are reused.
 */
-std::list<frames_ptr> frame_repository::m_frames;
+std::vector<frame_repository::frame_slot> frame_repository::m_slots;
+
+//! Indices of the released slots.
+std::vector<std::uint32_t> frame_repository::m_free;
 
-//! Internal counter of destructed frame holding objects.
+//! Intern table.
 /*!
-* Holds the number of objects destructed which had a reference to a frame
-* pointer.
+* Maps the hash of interned frames to the index of their slot.
 */
-std::size_t frame_repository::destruct_count = 0 ;
+frame_repository::intern_table frame_repository::m_interned;
+
+//! Number of released frames.
+std::size_t frame_repository::m_lifetimes = 0;
+
+//! Number of blocks requested for the released frames.
+std::size_t frame_repository::m_lifetime_allocations = 0;
 
 // Member functions
 
-//! Create pointer to frame storing structure.
+//! Create frame storing structure.
 /*!
-* Creates a pointer to a structure for storing frames, which then can be used by
-* an animation object to access frames.
+* Creates an empty structure for storing frames, which then can be used by an
+* animation object to access frames. The structure is released once the last
+* handle referring to it is released.
 *
 * NOTE: Since every instance of the animation class only needs one of these
-* pointers, this function should be called inside the constructor.
-* \param frm_ptr Pointer which will point to frame storing structure.
+* handles, this function should be called inside the constructor.
+* \param handle Handle which will refer to the frame storing structure.
+*/
+void frame_repository::create(frames_handle* handle) {
+
+	std::uint32_t index;
+
+	if (m_free.empty()) {
+
+		index = static_cast<std::uint32_t>(m_slots.size());
+		m_slots.push_back(frame_slot());
+		m_slots.back().generation = 1;
+
+	} else {
+
+		index = m_free.back();
+		m_free.pop_back();
+
+	}
+
+	auto& new_slot = m_slots[index];
+	new_slot.refs = 1;
+	new_slot.hash = 0;
+	new_slot.interned = false;
+	new_slot.dirty = true;
+	new_slot.tex_rect = sf::IntRect();
+	new_slot.rect_gen = 1;
+	new_slot.quad_gen = 1;
+	new_slot.allocations = 0;
+
+	*handle = make_handle(index);
+
+}
+
+//! Add a reference to frames.
+/*!
+* Has to be called for every copy of a handle, e.g. by the copy constructor of
+* an animation, which is later on released.
+* \param handle Handle which has been copied.
+*/
+void frame_repository::acquire(frames_handle handle) {
+
+	++ slot(handle).refs;
+
+}
+
+//! Release a reference to frames.
+/*!
+* Releases the frames once the last reference to them is released. Their slot
+* is then reused by the next create().
+* \param handle Handle to release, is set to NO_FRM.
+*/
+void frame_repository::release(frames_handle* handle) {
+
+	auto& old_slot = slot(*handle);
+
+	if (0 == -- old_slot.refs) {
+
+		if (old_slot.interned) {
+
+			unintern(static_cast<std::uint32_t>(*handle));
+
+		}
+
+		++ m_lifetimes;
+		m_lifetime_allocations += old_slot.allocations;
+
+		// Clearing keeps the arrays, so the next create() can reuse them.
+		old_slot.frames[ORIG_FRM].clear();
+		old_slot.frames[TEX_RECT_FRM].clear();
+		old_slot.rect_stamps.clear();
+		old_slot.quads.clear();
+		old_slot.quad_stamps.clear();
+		old_slot.durations.clear();
+
+		// Outdate all handles to the slot, skipping the invalid generation.
+		if (0 == ++ old_slot.generation) {
+
+			old_slot.generation = 1;
+
+		}
+
+		m_free.push_back(static_cast<std::uint32_t>(*handle));
+
+	}
+
+	*handle = NO_FRM;
+
+}
+
+//! Check whether a handle refers to frames.
+/*!
+* \param handle Handle to check.
+* \return True if the handle refers to frames which have not been released.
+*/
+bool frame_repository::valid(frames_handle handle) {
+
+	auto index = static_cast<std::uint32_t>(handle);
+
+	return index < m_slots.size() && 0 < m_slots[index].refs &&
+		   m_slots[index].generation == (handle >> 32);
+
+}
+
+//! Get frames for reading.
+/*!
+* Calculates the frames with the applied texture rectangle which are not up to
+* date, see clipped(), so both containers can be read.
+*
+* NOTE: Linear in the number of frames which are not up to date. Use size(),
+* original() and clipped() to read single frames.
+* \param handle Handle of the frames.
+* \return Frames referred to by the handle.
+*/
+const frame_storage& frame_repository::get(frames_handle handle) {
+
+	auto& own_slot = slot(handle);
+	resolve(own_slot);
+
+	return own_slot.frames;
+
+}
+
+//! Get frames for modification.
+/*!
+* If the frames are shared with other handles, the handle gets its own copy of
+* them first, which is then returned. The frames are taken out of the intern
+* table until the next intern(). Both containers are up to date, changes of
+* the frames with the applied texture rectangle are kept until the texture
+* rectangle changes.
+* \param handle Handle of the frames, may be changed to refer to the copy.
+* \return Frames referred to by the handle.
+*/
+frame_storage& frame_repository::edit(frames_handle* handle) {
+
+	auto& own_slot = own(handle);
+	resolve(own_slot);
+
+	own_slot.dirty = true;
+	next_gen(&own_slot.quad_gen, &own_slot.quad_stamps);
+
+	return own_slot.frames;
+
+}
+
+//! Share frames with identical ones.
+/*!
+* Looks the frames up inside the intern table. If the same frames, with the
+* same texture rectangle, are stored for another handle, the handle is changed
+* to share them and its own frames are released. Otherwise the frames are
+* added to the table. Does nothing if the frames have not been changed since
+* the last call.
+*
+* NOTE: Hashes and compares all frames, so call it once the frames are
+* complete, e.g. before rendering, not after every change. Changing only the
+* texture rectangle takes the frames out of the table without marking them for
+* the next call, since animations doing this, e.g. for reveal effects, most
+* likely change it again soon.
+* \param handle Handle of the frames, may be changed to refer to the shared
+* frames.
+*/
+void frame_repository::intern(frames_handle* handle) {
+
+	auto& own_slot = slot(*handle);
+
+	if (!own_slot.dirty) {
+
+		return;
+
+	}
+
+	resolve(own_slot);
+
+	auto index = static_cast<std::uint32_t>(*handle);
+	auto hash = hash_frames(own_slot.frames, own_slot.tex_rect);
+	auto range = m_interned.equal_range(hash);
+
+	for (auto it = range.first; it != range.second; ++ it) {
+
+		auto& other_slot = m_slots[it->second];
+
+		// The durations are not hashed, frames which only differ in them are
+		// rare.
+		if (other_slot.tex_rect == own_slot.tex_rect &&
+			other_slot.frames == own_slot.frames &&
+			other_slot.durations == own_slot.durations) {
+
+			auto other = make_handle(it->second);
+			acquire(other);
+			release(handle);
+			*handle = other;
+
+			return;
+
+		}
+
+	}
+
+	auto mark = frame_pool::requests();
+
+	own_slot.hash = hash;
+	own_slot.interned = true;
+	own_slot.dirty = false;
+	m_interned.insert(std::make_pair(hash, index));
+	own_slot.allocations += frame_pool::requests() - mark;
+
+}
+
+//! Check whether frames are shared.
+/*!
+* \param handle Handle of the frames.
+* \return True if other handles refer to the same frames.
+*/
+bool frame_repository::shared(frames_handle handle) {
+
+	return 1 < slot(handle).refs;
+
+}
+
+//! Number of frames.
+/*!
+* \param handle Handle of the frames.
+* \return Number of frames referred to by the handle.
+*/
+std::size_t frame_repository::size(frames_handle handle) {
+
+	return slot(handle).frames[ORIG_FRM].size();
+
+}
+
+//! Get an original frame.
+/*!
+* ATTENTION: No range checking for index.
+* \param handle Handle of the frames.
+* \param index Index of the frame.
+* \return Frame as it has been inserted.
+*/
+frame frame_repository::original(frames_handle handle, std::size_t index) {
+
+	return slot(handle).frames[ORIG_FRM][index];
+
+}
+
+//! Get a frame with the applied texture rectangle.
+/*!
+* The frames with the applied texture rectangle are calculated lazily: changing
+* the texture rectangle only increases a generation counter, each frame is
+* calculated again on its first access afterwards. So a texture rectangle
+* which changes every frame only costs the frames which are actually shown.
+*
+* ATTENTION: No range checking for index.
+* \param handle Handle of the frames.
+* \param index Index of the frame.
+* \return Frame with the applied texture rectangle.
+*/
+frame frame_repository::clipped(frames_handle handle, std::size_t index) {
+
+	auto& own_slot = slot(handle);
+	resolve(own_slot, index);
+
+	return own_slot.frames[TEX_RECT_FRM][index];
+
+}
+
+//! Get the quad of a frame.
+/*!
+* Returns the quad of the frame with the applied texture rectangle, so drawing
+* a frame only needs to copy its quad. The quad is built again on the first
+* access after the frame or the texture rectangle has been changed.
+*
+* ATTENTION: No range checking for index.
+*
+* NOTE: The reference is only valid until the frames are changed or the next
+* create().
+* \param handle Handle of the frames.
+* \param index Index of the frame.
+* \return Quad of the frame.
 */
-void frame_repository::create(frames_ptr* frm_ptr) {
+const frame_quad& frame_repository::quad(frames_handle handle,
+										 std::size_t index) {
+
+	auto& own_slot = slot(handle);
+	auto& quad = own_slot.quads[index];
+
+	if (own_slot.quad_gen != own_slot.quad_stamps[index]) {
 
-    // Create new frame storage and assign pointer for the animation.
-    // ATTENTION: Do not use emplace_back() here, it causes problems due to
-    // an error while initializing. Since temp is only valid in this scope, it
-    // won't cause any errors when dealing with use_count().
-/* \todo (lin#9#2014-08-15): The error was, that the intance of the shared_ptr
-which has been push backed was not initialized properly.
-This is fixed now, maybe try to simplify the code a little
-by making some typedefs.
+		resolve(own_slot, index);
 
-Also try to use emplace_back again. */
-	std::vector<frame> temp_vec;
-    frames_ptr temp(new std::array<std::vector<frame>, 2>);
-	temp->operator[](ORIG_FRM) = temp_vec;
-	temp->operator[](TEX_RECT_FRM) = temp_vec;
-    m_frames.push_back(temp);
-    *frm_ptr = m_frames.back();
+		auto& clipped = own_slot.frames[TEX_RECT_FRM];
+		auto left = static_cast<float>(clipped.x[index]);
+		auto top = static_cast<float>(clipped.y[index]);
+		auto right = left + clipped.w[index];
+		auto bottom = top + clipped.h[index];
+		auto off_x = static_cast<float>(clipped.ox[index]);
+		auto off_y = static_cast<float>(clipped.oy[index]);
+		auto width = off_x + std::abs(clipped.w[index]);
+		auto height = off_y + std::abs(clipped.h[index]);
+
+		// Trimmed frames are drawn at their place inside the logical frame.
+		quad.position[0] = sf::Vector2f(off_x, off_y);
+		quad.position[1] = sf::Vector2f(off_x, height);
+		quad.position[2] = sf::Vector2f(width, height);
+		quad.position[3] = sf::Vector2f(width, off_y);
+		quad.tex_coords[0] = sf::Vector2f(left, top);
+		quad.tex_coords[1] = sf::Vector2f(left, bottom);
+		quad.tex_coords[2] = sf::Vector2f(right, bottom);
+		quad.tex_coords[3] = sf::Vector2f(right, top);
+
+		own_slot.quad_stamps[index] = own_slot.quad_gen;
+
+	}
+
+	return quad;
 
 }
 
@@ -59,29 +363,15 @@ Also try to use emplace_back again. */
 * Inserts given frame into the repository list at the end. If a texture
 * rectangle other than an empty one is given, it is also applied to the frame
 * and stored inside.
-* \param frm_ptr Pointer to where the frames are stored for the animation.
+* \param handle Handle of the frames of the animation.
 * \param frm Frame to store.
 * \param tex_rect Texture rectangle to apply.
 * \return Index where the frame has been inserted.
 */
-std::size_t frame_repository::insert(frames_ptr* frm_ptr, const frame& frm,
+std::size_t frame_repository::insert(frames_handle* handle, const frame& frm,
                                      const sf::IntRect& tex_rect) {
 
-    (*frm_ptr)->operator[](ORIG_FRM).push_back(frm);
-
-    // If no texture rectangle is given, store the unmodified frame inside the
-    // texture rectangle storage as well. If one is given, apply and store.
-    if (sf::IntRect() == tex_rect) {
-
-        (*frm_ptr)->operator[](TEX_RECT_FRM).push_back(frm);
-
-    } else {
-
-        (*frm_ptr)->operator[](TEX_RECT_FRM).push_back(intersect(frm, tex_rect));
-
-    }
-
-    return ((*frm_ptr)->operator[](ORIG_FRM).size() - 1);
+    return insert(handle, &frm, 1, size(*handle), tex_rect);
 
 }
 
@@ -91,43 +381,67 @@ std::size_t frame_repository::insert(frames_ptr* frm_ptr, const frame& frm,
 * rectangle other than an empty one is given, it is also applied to the frame
 * and stored inside.
 *
-* ATTENTION: There should be at least one frame inside the repository, so this
-* function does not crash. Also, no range checking is done.
+* ATTENTION: No range checking is done, the index may be at most the number of
+* stored frames.
 *
-* ATTENTION: This function will iterate until the position of index, which is
-* considered O(index), linear complexity. Try to use the other overload, since
-* it is O(1), constsant complexity. Try to use the O(1) function.
-* the container.
-* \param frm_ptr Pointer to where the frames are stored for the animation.
+* ATTENTION: All frames behind the index are moved, which is linear in their
+* number. Use the other overload to append a frame, or the bulk insert to
+* insert several frames at once, which moves the frames only once.
+* \param handle Handle of the frames of the animation.
 * \param frm Frame to store.
 * \param index Index of where to store it.
 * \param tex_rect Texture rectangle to apply.
 * \return Index where the frame has been inserted (just returns index).
 */
-std::size_t frame_repository::insert(frames_ptr* frm_ptr, const frame& frm,
+std::size_t frame_repository::insert(frames_handle* handle, const frame& frm,
                                      std::size_t index,
                                      const sf::IntRect& tex_rect) {
 
-    // Get iterator at position index. Do it AFTER the emplace, to make sure
-    // that back() has an element to access.
-    auto it = (*frm_ptr)->operator[](ORIG_FRM).begin();
-    for (std::size_t i = 0; i <= index; ++ i) {
+    return insert(handle, &frm, 1, index, tex_rect);
 
-        ++ it;
+}
 
-    }
+//! Inserts several frames into the repository.
+/*!
+* Inserts the given frames into the repository list at given position, in
+* their order. If a texture rectangle other than an empty one is given, it is
+* also applied to the frames and stored inside. Both containers grow once for
+* all frames and the frames behind the index are moved only once, so inserting
+* many frames, like all frames of a frame group, takes linear time instead of
+* quadratic time.
+*
+* If the texture rectangle is the one of the frames, see apply_tex_rect(), it
+* is applied lazily, like after changing it. Otherwise it is applied right
+* away, and kept until the texture rectangle of the frames changes.
+*
+* ATTENTION: No range checking is done, the index may be at most the number of
+* stored frames.
+* \param handle Handle of the frames of the animation.
+* \param frms Frames to store.
+* \param count Number of frames to store.
+* \param index Index of where to store the first frame.
+* \param tex_rect Texture rectangle to apply.
+* \return Index where the first frame has been inserted (just returns index).
+*/
+std::size_t frame_repository::insert(frames_handle* handle, const frame* frms,
+                                     std::size_t count, std::size_t index,
+                                     const sf::IntRect& tex_rect) {
+
+    auto& own_slot = own(handle);
+    grow(own_slot, frms, frms, count, index);
 
-    (*frm_ptr)->operator[](ORIG_FRM).insert(it, frm);
+    // A different texture rectangle is applied right away.
+    if (own_slot.tex_rect != tex_rect) {
 
-    // If no texture rectangle is given, store the unmodified frame inside the
-    // texture rectangle storage as well. If one is given, apply and store.
-    if (sf::IntRect() == tex_rect) {
+        if (sf::IntRect() != tex_rect) {
 
-        (*frm_ptr)->operator[](TEX_RECT_FRM).insert(it, frm);
+            clip(own_slot.frames[ORIG_FRM], tex_rect,
+                 &own_slot.frames[TEX_RECT_FRM], index, count);
 
-    } else {
+        }
 
-        (*frm_ptr)->operator[](TEX_RECT_FRM).insert(it, intersect(frm, tex_rect));
+        std::fill_n(own_slot.rect_stamps.begin() + index, count,
+                    own_slot.rect_gen);
 
     }
 
@@ -135,11 +449,90 @@ std::size_t frame_repository::insert(frames_ptr* frm_ptr, const frame& frm,
 
 }
 
+//! Inserts several frames with their applied texture rectangle.
+/*!
+* Like the other bulk insert, but the texture rectangle has already been
+* applied to the frames by the caller, e.g. at compile time by a frame_table,
+* so nothing has to be calculated. The frames with the applied texture
+* rectangle are kept until the texture rectangle of the frames changes, so
+* they should have been calculated with the texture rectangle of the frames,
+* see apply_tex_rect().
+*
+* ATTENTION: No range checking is done, the index may be at most the number of
+* stored frames. The clipped frames are not checked against the texture
+* rectangle.
+* \param handle Handle of the frames of the animation.
+* \param frms Frames to store.
+* \param clipped Frames with the applied texture rectangle, one for each frame.
+* \param count Number of frames to store.
+* \param index Index of where to store the first frame.
+* \return Index where the first frame has been inserted (just returns index).
+*/
+std::size_t frame_repository::insert(frames_handle* handle, const frame* frms,
+                                     const frame* clipped, std::size_t count,
+                                     std::size_t index) {
+
+    auto& own_slot = own(handle);
+    grow(own_slot, frms, clipped, count, index);
+    std::fill_n(own_slot.rect_stamps.begin() + index, count,
+                own_slot.rect_gen);
+
+    return index;
+
+}
+
+//! Get the duration of a frame.
+/*!
+* ATTENTION: No range checking for index.
+* \param handle Handle of the frames.
+* \param index Index of the frame.
+* \return Time the frame is shown, zero for the default duration of the
+* animation.
+*/
+sf::Time frame_repository::duration(frames_handle handle, std::size_t index) {
+
+	return slot(handle).durations[index];
+
+}
+
+//! Set the durations of frames.
+/*!
+* Frames are inserted with a duration of zero, which means the default
+* duration of the animation showing them.
+*
+* ATTENTION: No range checking is done, all frames from index to
+* index + count - 1 have to exist.
+* \param handle Handle of the frames.
+* \param durations Time each frame is shown, zero for the default duration.
+* \param count Number of durations.
+* \param index Index of the frame which gets the first duration.
+*/
+void frame_repository::set_durations(frames_handle* handle,
+									 const sf::Time* durations,
+									 std::size_t count, std::size_t index) {
+
+	auto& own_slot = own(handle);
+	own_slot.dirty = true;
+
+	std::copy(durations, durations + count,
+			  own_slot.durations.begin() + index);
+
+}
+
 //! Checks whether frame and texture rectangle intersect.
 /*!
 * Checks if the given frame intersects with the texture rectangle. Returns the
 * intersection. In the case there is no intersection, an empty frame is
 * returned.
+*
+* A frame which is not trimmed keeps its position on the sprite sheet, only its
+* size is limited to the intersection with (0, 0, w, h).
+*
+* For a trimmed frame, the texture rectangle is given in the coordinates of the
+* logical frame, in which the frame covers its place from (ox, oy) on. The
+* intersection is moved on the sprite sheet by the part which has been clipped
+* off at the left and the top, and the part of the logical frame inside the
+* texture rectangle becomes its logical frame.
 * \param frm Frame of animation.
 * \param rect Texture rectangle of animation.
 * \return Intersecting rectangle as a frame.
@@ -147,43 +540,42 @@ std::size_t frame_repository::insert(frames_ptr* frm_ptr, const frame& frm,
 frame frame_repository::intersect(const frame& frm,
                                                const sf::IntRect& rect) {
 
-    // Create temporary rectangle to use intersection function.
-    auto temp = sf::IntRect(0, 0, frm.w, frm.h);
-    auto result = sf::IntRect();
-
-    // Check for intersection and store if there is one.
-    temp.intersects(rect, result);
-
-    // Convert to frame.
-    frame res_frame(frm.x, frm.y, result.width, result.height);
-
-    return res_frame;
+	// Rectangles may have a negative size, like in sf::Rect::intersects().
+	return clip(frm, std::min(rect.left, rect.left + rect.width),
+				std::min(rect.top, rect.top + rect.height),
+				std::max(rect.left, rect.left + rect.width),
+				std::max(rect.top, rect.top + rect.height));
 
 }
 
 //! Replace frame with new one.
 /*!
-* Replaces frame at position index with new index.
+* Replaces frame at position index with new index. The texture rectangle is
+* applied like by insert().
 *
 * ATTENTION: No range checking for frame.
-* \param frm_ptr Pointer to storage in which frame is.
+* \param handle Handle of the frames holding the frame.
 * \param other Frame which replaces frame at index position.
 * \param index Position of the frame which should be replaced.
+* \param rect Texture rectangle to apply.
 */
-void frame_repository::replace(frames_ptr* frm_ptr, const frame& other,
+void frame_repository::replace(frames_handle* handle, const frame& other,
                                std::size_t index, const sf::IntRect& rect) {
 
-    // Store frame in original storage and then apply texture rectangle and
-    // store.
-    (*frm_ptr)->operator[](ORIG_FRM).operator[](index) = other;
-    if (sf::IntRect() == rect) {
+    auto& own_slot = own(handle);
+    own_slot.dirty = true;
 
-        // No rect to apply.
-        (*frm_ptr)->operator[](TEX_RECT_FRM).operator[](index) = other;
+    // Store frame in original storage and then apply texture rectangle and
+    // store, unless it is the one of the frames.
+    own_slot.frames[ORIG_FRM].set(index, other);
+    own_slot.rect_stamps[index] = 0;
+    own_slot.quad_stamps[index] = 0;
 
-    } else {
+    if (own_slot.tex_rect != rect) {
 
-        (*frm_ptr)->operator[](TEX_RECT_FRM).operator[](index) = intersect(other, rect);
+        own_slot.frames[TEX_RECT_FRM].set(index, (sf::IntRect() == rect) ?
+                                          other : intersect(other, rect));
+        own_slot.rect_stamps[index] = own_slot.rect_gen;
 
     }
 
@@ -191,62 +583,682 @@ void frame_repository::replace(frames_ptr* frm_ptr, const frame& other,
 
 //! Applies texture rectangle to all frames in given repository.
 /*!
-* Applies texture rectangle to all frames currently stores inside the given
-* repository and then stores them in the texture rectangle frame storage.
-* \param frm_ptr Pointer to storage of frames which should be used.
+* Sets the texture rectangle of the frames. It is applied lazily to each frame
+* on its next access, see clipped(), so this takes constant time, unless the
+* frames are shared and have to be copied first. An empty rectangle shows the
+* original frames.
+* \param handle Handle of the frames which should be used.
 * \param tex_rect Texture rectangle which should be applied.
 */
-void frame_repository::apply_tex_rect(frames_ptr* frm_ptr,
+void frame_repository::apply_tex_rect(frames_handle* handle,
                                       const sf::IntRect& tex_rect) {
 
-    // Iterate through both vectors of frames (they are of the same size) and
-    // calculate the texture rectangle for each original frame.
-    auto orig_it = (*frm_ptr)->operator[](ORIG_FRM).begin();
-    auto tex_it = (*frm_ptr)->operator[](TEX_RECT_FRM).begin();
-    while (orig_it != (*frm_ptr)->operator[](ORIG_FRM).end()) {
+    if (slot(*handle).tex_rect == tex_rect) {
 
-        *tex_it = intersect(*orig_it, tex_rect);
-
-        // Increment iterators for next loop run.
-        ++ orig_it;
-        ++ tex_it;
+        return;
 
     }
 
+    auto& own_slot = own(handle);
+    own_slot.tex_rect = tex_rect;
+    next_gen(&own_slot.rect_gen, &own_slot.rect_stamps);
+    next_gen(&own_slot.quad_gen, &own_slot.quad_stamps);
+
+}
+
+//! Number of live frame storing structures.
+/*!
+* \return Number of slots which are currently in use.
+*/
+std::size_t frame_repository::live() {
+
+	return m_slots.size() - m_free.size();
+
+}
+
+//! Number of allocations of frames.
+/*!
+* \param handle Handle of the frames.
+* \return Number of blocks requested from the frame_pool for the frames since
+* their creation, including the copy made when they were shared.
+*/
+std::size_t frame_repository::allocations(frames_handle handle) {
+
+	return slot(handle).allocations;
+
+}
+
+//! Number of outdated frames.
+/*!
+* Counts the frames whose applied texture rectangle is calculated again on
+* their next access, see clipped(). Only meant for tests, since it walks over
+* all frames.
+* \param handle Handle of the frames.
+* \return Number of frames with an outdated applied texture rectangle.
+*/
+std::size_t frame_repository::outdated(frames_handle handle) {
+
+	auto& own_slot = slot(handle);
+
+	return static_cast<std::size_t>(std::count_if(
+		own_slot.rect_stamps.begin(), own_slot.rect_stamps.end(),
+		[&own_slot](std::uint32_t stamp) {
+
+			return own_slot.rect_gen != stamp;
+
+		}));
+
+}
+
+//! Get the allocation counters.
+/*!
+* Dividing the blocks requested for the released frames by their number gives
+* the allocations per lifetime of an animation.
+* \return Allocation counters since the start of the program.
+*/
+frame_repository::alloc_statistics frame_repository::alloc_stats() {
+
+	alloc_statistics stats;
+	stats.pool = frame_pool::stats();
+	stats.lifetimes = m_lifetimes;
+	stats.lifetime_allocations = m_lifetime_allocations;
+
+	return stats;
+
+}
+
+//! Get the own slot of a handle.
+/*!
+* If the frames are shared with other handles, the handle gets its own copy of
+* them first. The frames are taken out of the intern table, since the caller
+* is going to change them.
+* \param handle Handle of the frames, may be changed to refer to the copy.
+* \return Slot only referred to by the handle.
+*/
+frame_repository::frame_slot& frame_repository::own(frames_handle* handle) {
+
+	if (1 < slot(*handle).refs) {
+
+		auto mark = frame_pool::requests();
+
+		// Creating the slot may move all slots, so get both afterwards. The
+		// frames are assigned, so a reused slot keeps its arrays if they are
+		// big enough.
+		frames_handle copy = NO_FRM;
+		create(&copy);
+
+		auto& old_slot = slot(*handle);
+		auto& new_slot = slot(copy);
+		new_slot.frames = old_slot.frames;
+		new_slot.dirty = old_slot.dirty;
+		new_slot.tex_rect = old_slot.tex_rect;
+		new_slot.rect_gen = old_slot.rect_gen;
+		new_slot.rect_stamps = old_slot.rect_stamps;
+		new_slot.quads = old_slot.quads;
+		new_slot.quad_gen = old_slot.quad_gen;
+		new_slot.quad_stamps = old_slot.quad_stamps;
+		new_slot.durations = old_slot.durations;
+		new_slot.allocations = frame_pool::requests() - mark;
+
+		release(handle);
+		*handle = copy;
+
+	}
+
+	auto& own_slot = slot(*handle);
+
+	if (own_slot.interned) {
+
+		unintern(static_cast<std::uint32_t>(*handle));
+
+	}
+
+	return own_slot;
+
+}
+
+//! Make room for frames.
+/*!
+* Inserts the frames into all containers of the slot. The frames with the
+* applied texture rectangle are outdated, unless the caller stamps them.
+* \param target Slot to insert into.
+* \param frms Frames to store.
+* \param clipped Frames to store as frames with the applied texture rectangle.
+* \param count Number of frames to store.
+* \param index Index of where to store the first frame.
+*/
+void frame_repository::grow(frame_slot& target, const frame* frms,
+							const frame* clipped, std::size_t count,
+							std::size_t index) {
+
+	auto mark = frame_pool::requests();
+	target.dirty = true;
+
+	// All containers have the same size, so the index is the same position
+	// inside each of them.
+	target.frames[ORIG_FRM].insert(index, frms, count);
+	target.frames[TEX_RECT_FRM].insert(index, clipped, count);
+	target.rect_stamps.insert(target.rect_stamps.begin() + index, count, 0);
+	target.quads.insert(target.quads.begin() + index, count, frame_quad());
+	target.quad_stamps.insert(target.quad_stamps.begin() + index, count, 0);
+	target.durations.insert(target.durations.begin() + index, count,
+							sf::Time::Zero);
+	target.allocations += frame_pool::requests() - mark;
+
+}
+
+//! Apply the texture rectangle to all frames which are not up to date.
+/*!
+* Runs of outdated frames are clipped at once, see clip().
+* \param target Slot holding the frames.
+*/
+void frame_repository::resolve(frame_slot& target) {
+
+	auto& stamps = target.rect_stamps;
+	std::size_t first = 0;
+
+	while (first < stamps.size()) {
+
+		if (target.rect_gen == stamps[first]) {
+
+			++ first;
+			continue;
+
+		}
+
+		auto last = first + 1;
+		while (last < stamps.size() && target.rect_gen != stamps[last]) {
+
+			++ last;
+
+		}
+
+		update(target, first, last - first);
+		first = last;
+
+	}
+
+}
+
+//! Apply the texture rectangle to a frame if it is not up to date.
+/*!
+* \param target Slot holding the frame.
+* \param index Index of the frame.
+*/
+void frame_repository::resolve(frame_slot& target, std::size_t index) {
+
+	if (target.rect_gen != target.rect_stamps[index]) {
+
+		update(target, index, 1);
+
+	}
+
+}
+
+//! Apply the texture rectangle to a range of frames.
+/*!
+* \param target Slot holding the frames.
+* \param first Index of the first frame of the range.
+* \param count Number of frames of the range.
+*/
+void frame_repository::update(frame_slot& target, std::size_t first,
+							  std::size_t count) {
+
+	auto& orig = target.frames[ORIG_FRM];
+	auto& clipped = target.frames[TEX_RECT_FRM];
+
+	if (sf::IntRect() == target.tex_rect) {
+
+		for (std::size_t i = first; i < first + count; ++ i) {
+
+			clipped.set(i, orig[i]);
+
+		}
+
+	} else {
+
+		clip(orig, target.tex_rect, &clipped, first, count);
+
+	}
+
+	std::fill_n(target.rect_stamps.begin() + first, count, target.rect_gen);
+
+}
+
+//! Start a new generation.
+/*!
+* Outdates everything stamped with the current generation. If the counter
+* wraps around, all stamps are reset, so no stamp of an old generation can
+* match a new one.
+* \param gen Generation counter.
+* \param stamps Generation of each frame, zero if it is outdated anyway.
+*/
+void frame_repository::next_gen(std::uint32_t* gen,
+								pool_vector<std::uint32_t>* stamps) {
+
+	if (0 == ++ *gen) {
+
+		*gen = 1;
+		std::fill(stamps->begin(), stamps->end(), 0);
+
+	}
+
+}
+
+//! Create the handle of a slot.
+/*!
+* \param index Index of the slot.
+* \return Handle referring to the current generation of the slot.
+*/
+frames_handle frame_repository::make_handle(std::uint32_t index) {
+
+	return (static_cast<frames_handle>(m_slots[index].generation) << 32) |
+		   index;
+
+}
+
+//! Remove frames from the intern table.
+/*!
+* \param index Index of the slot holding the frames.
+*/
+void frame_repository::unintern(std::uint32_t index) {
+
+	auto& old_slot = m_slots[index];
+	auto range = m_interned.equal_range(old_slot.hash);
+
+	for (auto it = range.first; it != range.second; ++ it) {
+
+		if (index == it->second) {
+
+			m_interned.erase(it);
+			break;
+
+		}
+
+	}
+
+	old_slot.interned = false;
+
+}
+
+//! Hash frames.
+/*!
+* FNV-1a over the texture rectangle and all values of all frames of both
+* containers.
+* \param frames Frames to hash.
+* \param tex_rect Texture rectangle of the frames.
+* \return Hash of the frames.
+*/
+std::uint64_t frame_repository::hash_frames(const frame_storage& frames,
+											const sf::IntRect& tex_rect) {
+
+	std::uint64_t hash = 14695981039346656037ULL;
+
+	for (auto value : {tex_rect.left, tex_rect.top, tex_rect.width,
+					   tex_rect.height}) {
+
+		hash ^= static_cast<std::uint32_t>(value);
+		hash *= 1099511628211ULL;
+
+	}
+
+	for (auto& container : frames) {
+
+		for (auto values : {&container.x, &container.y, &container.w,
+							&container.h, &container.ox, &container.oy,
+							&container.lw, &container.lh}) {
+
+			for (auto value : *values) {
+
+				hash ^= static_cast<std::uint32_t>(value);
+				hash *= 1099511628211ULL;
+
+			}
+
+		}
+
+		// Separate the containers, so frames do not just move between them.
+		hash ^= container.size();
+		hash *= 1099511628211ULL;
+
+	}
+
+	return hash;
+
+}
+
+//! Apply texture rectangle to a range of frames.
+/*!
+* Does the same as intersect() for each frame of the range, but works on the
+* arrays of the frame sets: with SSE2, the intersection is calculated for four
+* frames at once with min/max operations, the remaining frames and builds
+* without SSE2 use the scalar loop.
+* \param orig Original frames.
+* \param rect Texture rectangle to apply.
+* \param clipped Frames which receive the intersections, of the same size.
+* \param first Index of the first frame of the range.
+* \param count Number of frames of the range.
+*/
+void frame_repository::clip(const frame_set& orig, const sf::IntRect& rect,
+							frame_set* clipped, std::size_t first,
+							std::size_t count) {
+
+	auto last = first + count;
+
+	// Rectangles may have a negative size, like in sf::Rect::intersects().
+	auto rect_left = std::min(rect.left, rect.left + rect.width);
+	auto rect_right = std::max(rect.left, rect.left + rect.width);
+	auto rect_top = std::min(rect.top, rect.top + rect.height);
+	auto rect_bottom = std::max(rect.top, rect.top + rect.height);
+
+	auto i = first;
+
+#ifdef __SSE2__
+
+	// SSE2 has no min/max for 32 bit integers, so select by comparison.
+	auto min4 = [](__m128i a, __m128i b) {
+
+		auto greater = _mm_cmpgt_epi32(a, b);
+		return _mm_or_si128(_mm_and_si128(greater, b),
+							_mm_andnot_si128(greater, a));
+
+	};
+	auto max4 = [](__m128i a, __m128i b) {
+
+		auto greater = _mm_cmpgt_epi32(a, b);
+		return _mm_or_si128(_mm_and_si128(greater, a),
+							_mm_andnot_si128(greater, b));
+
+	};
+	auto load4 = [](const pool_vector<int>& values, std::size_t index) {
+
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(
+							   values.data() + index));
+
+	};
+	auto store4 = [](pool_vector<int>* values, std::size_t index,
+					 __m128i value) {
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(values->data() + index),
+						 value);
+
+	};
+
+	auto zero = _mm_setzero_si128();
+	auto left = _mm_set1_epi32(rect_left);
+	auto right = _mm_set1_epi32(rect_right);
+	auto top = _mm_set1_epi32(rect_top);
+	auto bottom = _mm_set1_epi32(rect_bottom);
+
+	// Start of the part of the logical frame inside the rectangle.
+	auto window_left = _mm_set1_epi32(std::max(0, rect_left));
+	auto window_top = _mm_set1_epi32(std::max(0, rect_top));
+
+	for (; i + 4 <= last; i += 4) {
+
+		auto w = load4(orig.w, i);
+		auto h = load4(orig.h, i);
+		auto ox = load4(orig.ox, i);
+		auto oy = load4(orig.oy, i);
+
+		// The frame spans from its offset to its offset plus its size.
+		auto frame_left = min4(ox, _mm_add_epi32(ox, w));
+		auto frame_top = min4(oy, _mm_add_epi32(oy, h));
+		auto visible_left = max4(frame_left, left);
+		auto visible_top = max4(frame_top, top);
+		auto width = _mm_sub_epi32(min4(max4(ox, _mm_add_epi32(ox, w)), right),
+								   visible_left);
+		auto height = _mm_sub_epi32(min4(max4(oy, _mm_add_epi32(oy, h)),
+										 bottom), visible_top);
+
+		// The logical frame spans from zero to its logical size, which is the
+		// size of the frame if it is not trimmed.
+		auto lw = load4(orig.lw, i);
+		auto lh = load4(orig.lh, i);
+		auto no_lw = _mm_cmpeq_epi32(lw, zero);
+		auto no_lh = _mm_cmpeq_epi32(lh, zero);
+		lw = _mm_or_si128(_mm_and_si128(no_lw,
+										max4(w, _mm_sub_epi32(zero, w))),
+						  _mm_andnot_si128(no_lw, lw));
+		lh = _mm_or_si128(_mm_and_si128(no_lh,
+										max4(h, _mm_sub_epi32(zero, h))),
+						  _mm_andnot_si128(no_lh, lh));
+		auto window_w = _mm_sub_epi32(min4(lw, right), window_left);
+		auto window_h = _mm_sub_epi32(min4(lh, bottom), window_top);
+
+		// A frame is trimmed if it has an offset or a logical size.
+		auto plain = _mm_and_si128(
+			_mm_and_si128(_mm_cmpeq_epi32(ox, zero), _mm_cmpeq_epi32(oy, zero)),
+			_mm_and_si128(no_lw, no_lh));
+
+		// Frames which do not intersect in both directions get no size, for
+		// trimmed frames the logical frame has to intersect as well.
+		auto hit = _mm_and_si128(_mm_cmpgt_epi32(width, zero),
+								 _mm_cmpgt_epi32(height, zero));
+		hit = _mm_and_si128(hit, _mm_or_si128(plain, _mm_and_si128(
+							_mm_cmpgt_epi32(window_w, zero),
+							_mm_cmpgt_epi32(window_h, zero))));
+		auto trim_hit = _mm_andnot_si128(plain, hit);
+
+		// Move trimmed frames by the part clipped off at the left and the top.
+		store4(&clipped->x, i, _mm_add_epi32(load4(orig.x, i),
+					 _mm_and_si128(_mm_sub_epi32(visible_left, frame_left),
+								   trim_hit)));
+		store4(&clipped->y, i, _mm_add_epi32(load4(orig.y, i),
+					 _mm_and_si128(_mm_sub_epi32(visible_top, frame_top),
+								   trim_hit)));
+		store4(&clipped->w, i, _mm_and_si128(width, hit));
+		store4(&clipped->h, i, _mm_and_si128(height, hit));
+		store4(&clipped->ox, i, _mm_and_si128(
+			   _mm_sub_epi32(visible_left, window_left), trim_hit));
+		store4(&clipped->oy, i, _mm_and_si128(
+			   _mm_sub_epi32(visible_top, window_top), trim_hit));
+		store4(&clipped->lw, i, _mm_and_si128(window_w, trim_hit));
+		store4(&clipped->lh, i, _mm_and_si128(window_h, trim_hit));
+
+	}
+
+#endif
+
+	for (; i < last; ++ i) {
+
+		clipped->set(i, clip(orig[i], rect_left, rect_top, rect_right,
+							 rect_bottom));
+
+	}
+
+}
+
+//! Apply texture rectangle to a frame.
+/*!
+* See intersect(), the rectangle is given by its bounds.
+* \param frm Frame to clip.
+* \param left Left bound of the texture rectangle.
+* \param top Top bound of the texture rectangle.
+* \param right Right bound of the texture rectangle, not less than left.
+* \param bottom Bottom bound of the texture rectangle, not less than top.
+* \return Visible part of the frame.
+*/
+frame frame_repository::clip(const frame& frm, int left, int top, int right,
+							 int bottom) {
+
+	// The frame spans from its offset to its offset plus its size, and the
+	// logical frame from zero to its logical size.
+	auto frame_left = std::min(frm.ox, frm.ox + frm.w);
+	auto frame_top = std::min(frm.oy, frm.oy + frm.h);
+	auto visible_left = std::max(frame_left, left);
+	auto visible_top = std::max(frame_top, top);
+	auto width = std::min(std::max(frm.ox, frm.ox + frm.w), right) -
+				 visible_left;
+	auto height = std::min(std::max(frm.oy, frm.oy + frm.h), bottom) -
+				  visible_top;
+
+	if (!frm.trimmed()) {
+
+		// Plain frames keep their position, see intersect().
+		if (width <= 0 || height <= 0) {
+
+			return frame(frm.x, frm.y, 0, 0);
+
+		}
+
+		return frame(frm.x, frm.y, width, height);
+
+	}
+
+	auto logical = frm.logical_size();
+	auto window_left = std::max(0, left);
+	auto window_top = std::max(0, top);
+	auto window_w = std::min(logical.x, right) - window_left;
+	auto window_h = std::min(logical.y, bottom) - window_top;
+
+	if (width <= 0 || height <= 0 || window_w <= 0 || window_h <= 0) {
+
+		return frame(frm.x, frm.y, 0, 0);
+
+	}
+
+	// Move by the part clipped off at the left and the top.
+	return frame(frm.x + visible_left - frame_left,
+				 frm.y + visible_top - frame_top, width, height,
+				 visible_left - window_left, visible_top - window_top,
+				 window_w, window_h);
+
+}
+
+//! Get the slot of a handle.
+/*!
+* \param handle Handle of the frames.
+* \return Slot holding the frames.
+*/
+frame_repository::frame_slot& frame_repository::slot(frames_handle handle) {
+
+	assert(valid(handle));
+
+	return m_slots[static_cast<std::uint32_t>(handle)];
+
 }
 
-//! Test whether to destruct a frame or not.
+// frame_set member functions
+
+//! Get a frame.
 /*!
-* This function is passed to std::list::remove_if() to be the condition under
-* which a frame is removed from the list. If the use count of a frame
-* pointer is one, only the std::list refers to it anymore, so it can be
-* destructed without any damage.
-* \param frm_ptr Frame pointer to the frame object.
-* \return True if std::shared_ptr::use_count() equals 1.
+* ATTENTION: No range checking for index.
+* \param index Index of the frame.
+* \return Copy of the frame.
 */
-bool frame_repository::remove_frame(const frames_ptr& frm_ptr) {
+frame frame_set::operator[](std::size_t index) const {
 
-    return 1 == frm_ptr.use_count();
+	return frame(x[index], y[index], w[index], h[index], ox[index], oy[index],
+				 lw[index], lh[index]);
 
 }
 
-//! Removes all unused frames from the list if needed.
+//! Overwrite a frame.
 /*!
-* This function should be called in any object's destructor which uses frames.
-* It basically handles a counter which is increased everytime an object is
-* release that had a reference to a frame pointer. Once this counter is half the
-*  size of the internal frame list, a function is called to garbage collect all
-* unused textures.
+* ATTENTION: No range checking for index.
+* \param index Index of the frame.
+* \param frm New frame.
 */
-void frame_repository::tidy() {
+void frame_set::set(std::size_t index, const frame& frm) {
 
-    ++ destruct_count;
+	x[index] = frm.x;
+	y[index] = frm.y;
+	w[index] = frm.w;
+	h[index] = frm.h;
+	ox[index] = frm.ox;
+	oy[index] = frm.oy;
+	lw[index] = frm.lw;
+	lh[index] = frm.lh;
 
-	if (m_frames.size() < destruct_count) {
+}
 
-        m_frames.remove_if(remove_frame);
-        destruct_count = 0;
+//! Number of frames.
+/*!
+* \return Number of frames inside the set.
+*/
+std::size_t frame_set::size() const {
+
+	return x.size();
+
+}
+
+//! Check whether there are frames.
+/*!
+* \return True if the set holds no frames.
+*/
+bool frame_set::empty() const {
+
+	return x.empty();
+
+}
+
+//! Append a frame.
+/*!
+* \param frm Frame to append.
+*/
+void frame_set::push_back(const frame& frm) {
+
+	x.push_back(frm.x);
+	y.push_back(frm.y);
+	w.push_back(frm.w);
+	h.push_back(frm.h);
+	ox.push_back(frm.ox);
+	oy.push_back(frm.oy);
+	lw.push_back(frm.lw);
+	lh.push_back(frm.lh);
+
+}
+
+//! Insert frames.
+/*!
+* Each array grows once and moves the values behind the index once.
+* \param index Index where to insert the first frame.
+* \param frms Frames to insert.
+* \param count Number of frames to insert.
+*/
+void frame_set::insert(std::size_t index, const frame* frms,
+					   std::size_t count) {
+
+	x.insert(x.begin() + index, count, 0);
+	y.insert(y.begin() + index, count, 0);
+	w.insert(w.begin() + index, count, 0);
+	h.insert(h.begin() + index, count, 0);
+	ox.insert(ox.begin() + index, count, 0);
+	oy.insert(oy.begin() + index, count, 0);
+	lw.insert(lw.begin() + index, count, 0);
+	lh.insert(lh.begin() + index, count, 0);
+
+	for (std::size_t i = 0; i < count; ++ i) {
+
+		set(index + i, frms[i]);
 
 	}
 
 }
+
+//! Remove all frames.
+void frame_set::clear() {
+
+	x.clear();
+	y.clear();
+	w.clear();
+	h.clear();
+	ox.clear();
+	oy.clear();
+	lw.clear();
+	lh.clear();
+
+}
+
+//! Equality comparison.
+/*!
+* \param other Frame set to compare with.
+* \return True if both sets hold the same frames in the same order.
+*/
+bool frame_set::operator==(const frame_set& other) const {
+
+	return x == other.x && y == other.y && w == other.w && h == other.h &&
+		   ox == other.ox && oy == other.oy && lw == other.lw && lh == other.lh;
+
+}
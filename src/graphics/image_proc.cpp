@@ -0,0 +1,437 @@
+// image_proc.cpp
+
+#include "image_proc.hpp"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Member functions
+
+//! Cut an area out of an image.
+/*!
+* The area is clipped to the image, the same way sf::Texture::loadFromImage()
+* clips the area it loads, so the result never holds pixels outside of the
+* image. An area which does not overlap the image at all cuts out the whole
+* image, like texture_repository::load_view() does.
+* \param image Image to cut the area out of.
+* \param area Area to cut out.
+* \return New image holding only the area.
+*/
+sf::Image image_proc::crop(const sf::Image& image, const sf::IntRect& area) {
+
+	sf::IntRect whole(0, 0, image.getSize().x, image.getSize().y);
+	sf::IntRect rect;
+
+	if (!whole.intersects(area, rect)) {
+
+		return image;
+
+	}
+
+	sf::Image part;
+	part.create(rect.width, rect.height, sf::Color::Transparent);
+	part.copy(image, 0, 0, rect);
+
+	return part;
+
+}
+
+//! Scale an image down.
+/*!
+* Resamples the image to the target size with a box filter: every pixel of the
+* result is the average of the area of the image it covers, with the pixels
+* at the border of the area weighted by how much of them is covered. The filter
+* is applied horizontally first and vertically afterwards.
+*
+* The colors are weighted by their alpha value while averaging, so transparent
+* pixels do not darken the edges of opaque ones.
+*
+* NOTE: Images are only ever scaled down, see target_size(). The inner loops
+* work on all four channels of a pixel at once and are kept free of branches,
+* so the compiler can vectorize them.
+* \param image Image to scale.
+* \param size Target size, a zero component keeps the size of that axis.
+* \return Scaled image, or a copy of the image if nothing has to be scaled.
+*/
+sf::Image image_proc::resample(const sf::Image& image,
+							   const sf::Vector2u& size) {
+
+	auto src_size = image.getSize();
+	auto dst_size = target_size(src_size, size);
+
+	if (dst_size == src_size) {
+
+		return image;
+
+	}
+
+	// Calculate which source pixels contribute to a target pixel, and with
+	// which weight. The weights of one target pixel sum up to one.
+	struct contrib {
+
+		unsigned int first;
+		std::vector<float> weights;
+
+	};
+
+	auto calc_contribs = [](unsigned int src, unsigned int dst) {
+
+		std::vector<contrib> result(dst);
+		auto scale = static_cast<double>(src) / dst;
+
+		for (unsigned int i = 0; i < dst; ++ i) {
+
+			auto begin = i * scale;
+			auto end = begin + scale;
+			auto first = static_cast<unsigned int>(std::floor(begin));
+			auto last = std::min(src, static_cast<unsigned int>(std::ceil(end)));
+
+			result[i].first = first;
+			for (auto j = first; j < last; ++ j) {
+
+				auto covered = std::min<double>(end, j + 1) -
+							   std::max<double>(begin, j);
+				result[i].weights.push_back(static_cast<float>(covered / scale));
+
+			}
+
+		}
+
+		return result;
+
+	};
+
+	auto cols = calc_contribs(src_size.x, dst_size.x);
+	auto rows = calc_contribs(src_size.y, dst_size.y);
+
+	// Horizontal pass, into premultiplied floating point pixels.
+	std::vector<float> temp(static_cast<std::size_t>(src_size.y) *
+							dst_size.x * 4, 0.f);
+	auto src = image.getPixelsPtr();
+
+	for (unsigned int y = 0; y < src_size.y; ++ y) {
+
+		auto src_row = src + static_cast<std::size_t>(y) * src_size.x * 4;
+		auto temp_row = temp.data() + static_cast<std::size_t>(y) *
+						dst_size.x * 4;
+
+		for (unsigned int x = 0; x < dst_size.x; ++ x) {
+
+			float sum[4] = {0.f, 0.f, 0.f, 0.f};
+			auto pixel = src_row + static_cast<std::size_t>(cols[x].first) * 4;
+
+			for (auto weight : cols[x].weights) {
+
+				auto alpha = weight * pixel[3];
+				sum[0] += alpha * pixel[0];
+				sum[1] += alpha * pixel[1];
+				sum[2] += alpha * pixel[2];
+				sum[3] += alpha * 255.f;
+				pixel += 4;
+
+			}
+
+			for (int c = 0; c < 4; ++ c) {
+
+				temp_row[x * 4 + c] = sum[c];
+
+			}
+
+		}
+
+	}
+
+	// Vertical pass, back to straight alpha.
+	std::vector<sf::Uint8> pixels(static_cast<std::size_t>(dst_size.x) *
+								  dst_size.y * 4);
+	std::vector<float> sum(static_cast<std::size_t>(dst_size.x) * 4);
+
+	for (unsigned int y = 0; y < dst_size.y; ++ y) {
+
+		std::fill(sum.begin(), sum.end(), 0.f);
+
+		auto row = rows[y].first;
+		for (auto weight : rows[y].weights) {
+
+			auto temp_row = temp.data() + static_cast<std::size_t>(row) *
+							dst_size.x * 4;
+			for (std::size_t i = 0; i < sum.size(); ++ i) {
+
+				sum[i] += weight * temp_row[i];
+
+			}
+
+			++ row;
+
+		}
+
+		auto dst_row = pixels.data() + static_cast<std::size_t>(y) *
+					   dst_size.x * 4;
+		for (unsigned int x = 0; x < dst_size.x; ++ x) {
+
+			// The alpha sum is premultiplied with 255 as well.
+			auto alpha = sum[x * 4 + 3];
+			auto factor = (0.f < alpha) ? 255.f / alpha : 0.f;
+
+			for (int c = 0; c < 3; ++ c) {
+
+				dst_row[x * 4 + c] = static_cast<sf::Uint8>(
+					std::min(255.f, sum[x * 4 + c] * factor + 0.5f));
+
+			}
+
+			dst_row[x * 4 + 3] = static_cast<sf::Uint8>(
+				std::min(255.f, alpha / 255.f + 0.5f));
+
+		}
+
+	}
+
+	sf::Image result;
+	result.create(dst_size.x, dst_size.y, pixels.data());
+
+	return result;
+
+}
+
+//! Calculate the size of a resampled image.
+/*!
+* The image is only scaled down along the axes on which the target size is
+* smaller than the image. Axes with a zero target size keep their size.
+* \param image_size Size of the image.
+* \param size Target size.
+* \return Size of the image after resampling.
+*/
+sf::Vector2u image_proc::target_size(const sf::Vector2u& image_size,
+									 const sf::Vector2u& size) {
+
+	return sf::Vector2u(
+		(0 < size.x && size.x < image_size.x) ? size.x : image_size.x,
+		(0 < size.y && size.y < image_size.y) ? size.y : image_size.y);
+
+}
+
+//! Trim the transparent border of a frame.
+/*!
+* Finds the smallest rectangle of the frame holding all pixels whose alpha
+* value is above the threshold. The returned frame only covers that
+* rectangle, its offset places it inside the frame, which becomes its logical
+* frame, see frame. So an animation drawing it keeps the size of the frame,
+* but only draws the opaque pixels.
+*
+* The first and last rows holding an opaque pixel are searched from the top
+* and from the bottom. The rows in between are only scanned left of the
+* leftmost and right of the rightmost opaque pixel found so far, see
+* first_opaque() and last_opaque().
+*
+* NOTE: Pixels of the frame outside of the image count as transparent.
+* \param image Sprite sheet holding the frame.
+* \param cell Frame to trim, without offset.
+* \param threshold Highest alpha value which counts as transparent.
+* \return Trimmed frame. Frames without a size are returned unchanged, frames
+* without an opaque pixel get no size.
+*/
+frame image_proc::trim(const sf::Image& image, const frame& cell,
+					   sf::Uint8 threshold) {
+
+	if (0 >= cell.w || 0 >= cell.h) {
+
+		return cell;
+
+	}
+
+	auto image_size = image.getSize();
+	auto pixels = image.getPixelsPtr();
+	auto row = [pixels, &image_size](int y) {
+
+		return pixels + static_cast<std::size_t>(y) * image_size.x * 4;
+
+	};
+
+	// Part of the frame inside the image.
+	auto x0 = std::max(cell.x, 0);
+	auto y0 = std::max(cell.y, 0);
+	auto x1 = std::min(cell.x + cell.w, static_cast<int>(image_size.x));
+	auto y1 = std::min(cell.y + cell.h, static_cast<int>(image_size.y));
+
+	auto top = y0;
+	while (top < y1 && x1 == first_opaque(row(top), x0, x1, threshold)) {
+
+		++ top;
+
+	}
+
+	if (x1 <= x0 || y1 <= top) {
+
+		return frame(cell.x, cell.y, 0, 0, 0, 0, cell.w, cell.h);
+
+	}
+
+	// There is an opaque row, so this stops at the top one at the latest.
+	auto bottom = y1 - 1;
+	while (x1 == first_opaque(row(bottom), x0, x1, threshold)) {
+
+		-- bottom;
+
+	}
+
+	auto left = x1;
+	auto right = x0 - 1;
+
+	for (auto y = top; y <= bottom; ++ y) {
+
+		left = first_opaque(row(y), x0, left, threshold);
+		right = last_opaque(row(y), right + 1, x1, threshold);
+
+	}
+
+	return frame(left, top, right - left + 1, bottom - top + 1, left - cell.x,
+				 top - cell.y, cell.w, cell.h);
+
+}
+
+//! Split a frame group into trimmed frames.
+/*!
+* Splits the frame group like animation::insert() does, and trims each frame,
+* see trim().
+* \param image Sprite sheet holding the frame group.
+* \param frm_grp Frame group to split.
+* \param threshold Highest alpha value which counts as transparent.
+* \return Trimmed frames inside the frame group, row by row.
+*/
+std::vector<frame> image_proc::slice(const sf::Image& image,
+									 const frame_group& frm_grp,
+									 sf::Uint8 threshold) {
+
+	std::vector<frame> frms;
+
+	if (0 >= frm_grp.w || 0 >= frm_grp.h) {
+
+		return frms;
+
+	}
+
+	auto rows = frm_grp.sh / frm_grp.h;
+	auto cols = frm_grp.sw / frm_grp.w;
+	frms.reserve(static_cast<std::size_t>(std::max(rows * cols, 0)));
+
+	for (int i = 0; i < rows; ++ i) {
+
+		for (int j = 0; j < cols; ++ j) {
+
+			frms.push_back(trim(image,
+								frame(frm_grp.x + j * frm_grp.w,
+									  frm_grp.y + i * frm_grp.h,
+									  frm_grp.w, frm_grp.h),
+								threshold));
+
+		}
+
+	}
+
+	return frms;
+
+}
+
+//! Find the first opaque pixel of a row.
+/*!
+* With SSE2, the alpha values of four pixels are compared at once.
+* \param row First pixel of the row.
+* \param begin Index of the first pixel to check.
+* \param end Index behind the last pixel to check.
+* \param threshold Highest alpha value which counts as transparent.
+* \return Index of the first opaque pixel, end if there is none.
+*/
+int image_proc::first_opaque(const sf::Uint8* row, int begin, int end,
+							 sf::Uint8 threshold) {
+
+	auto i = begin;
+
+#ifdef __SSE2__
+
+	auto limit = _mm_set1_epi32(threshold);
+
+	for (; i + 4 <= end; i += 4) {
+
+		// The alpha value is the highest byte of each pixel.
+		auto block = reinterpret_cast<const __m128i*>(row + i * 4);
+		auto pixels = _mm_loadu_si128(block);
+		auto opaque = _mm_cmpgt_epi32(_mm_srli_epi32(pixels, 24), limit);
+		auto mask = _mm_movemask_ps(_mm_castsi128_ps(opaque));
+
+		if (0 != mask) {
+
+			return i + ((mask & 1) ? 0 : (mask & 2) ? 1 : (mask & 4) ? 2 : 3);
+
+		}
+
+	}
+
+#endif
+
+	for (; i < end; ++ i) {
+
+		if (threshold < row[i * 4 + 3]) {
+
+			return i;
+
+		}
+
+	}
+
+	return end;
+
+}
+
+//! Find the last opaque pixel of a row.
+/*!
+* With SSE2, the alpha values of four pixels are compared at once.
+* \param row First pixel of the row.
+* \param begin Index of the first pixel to check.
+* \param end Index behind the last pixel to check.
+* \param threshold Highest alpha value which counts as transparent.
+* \return Index of the last opaque pixel, begin - 1 if there is none.
+*/
+int image_proc::last_opaque(const sf::Uint8* row, int begin, int end,
+							sf::Uint8 threshold) {
+
+	auto i = end;
+
+#ifdef __SSE2__
+
+	auto limit = _mm_set1_epi32(threshold);
+
+	for (; begin <= i - 4; i -= 4) {
+
+		auto block = reinterpret_cast<const __m128i*>(row + (i - 4) * 4);
+		auto pixels = _mm_loadu_si128(block);
+		auto opaque = _mm_cmpgt_epi32(_mm_srli_epi32(pixels, 24), limit);
+		auto mask = _mm_movemask_ps(_mm_castsi128_ps(opaque));
+
+		if (0 != mask) {
+
+			return i - 4 + ((mask & 8) ? 3 : (mask & 4) ? 2 :
+							(mask & 2) ? 1 : 0);
+
+		}
+
+	}
+
+#endif
+
+	for (-- i; begin <= i; -- i) {
+
+		if (threshold < row[i * 4 + 3]) {
+
+			return i;
+
+		}
+
+	}
+
+	return begin - 1;
+
+}
@@ -0,0 +1,274 @@
+// lz_codec.cpp
+
+#include "lz_codec.hpp"
+#include <cstring>
+
+// Member variables
+
+//! Shortest match which is worth to be encoded.
+const std::size_t lz_codec::min_match;
+
+//! Largest distance a match may have.
+const std::size_t lz_codec::max_offset;
+
+//! Number of bits of the hash table index.
+const unsigned int lz_codec::hash_bits;
+
+// Member functions
+
+//! Compress a block of memory.
+/*!
+* Looks up the last position of each four bytes in a hash table, and encodes
+* them as match if the bytes there are the same. While nothing matches, the
+* search skips ahead faster and faster, so data which does not compress costs
+* little time.
+* \param data Data to compress.
+* \param size Size of the data.
+* \return Compressed data.
+*/
+std::vector<std::uint8_t> lz_codec::compress(const std::uint8_t* data,
+											 std::size_t size) {
+
+	std::vector<std::uint8_t> out;
+	out.reserve(size / 2 + 16);
+
+	// Position plus one of the last occurrence of each hash, zero if none.
+	std::vector<std::size_t> table(std::size_t(1) << hash_bits, 0);
+
+	std::size_t anchor = 0;
+	std::size_t pos = 0;
+
+	while (pos + min_match <= size) {
+
+		auto hash = hash32(read32(data + pos));
+		auto candidate = table[hash];
+		table[hash] = pos + 1;
+
+		if (0 == candidate || max_offset < pos + 1 - candidate ||
+			read32(data + candidate - 1) != read32(data + pos)) {
+
+			// Skip ahead faster the longer nothing has matched.
+			pos += 1 + ((pos - anchor) >> 6);
+			continue;
+
+		}
+
+		auto match = candidate - 1;
+		auto length = min_match;
+		while (pos + length < size &&
+			   data[match + length] == data[pos + length]) {
+
+			++ length;
+
+		}
+
+		// Token, literals, offset and match length.
+		auto literals = pos - anchor;
+		auto match_code = length - min_match;
+		out.push_back(static_cast<std::uint8_t>(
+					  ((15 < literals ? 15 : literals) << 4) |
+					  (15 < match_code ? 15 : match_code)));
+
+		if (15 <= literals) {
+
+			put_length(&out, literals - 15);
+
+		}
+
+		out.insert(out.end(), data + anchor, data + pos);
+
+		auto offset = pos - match;
+		out.push_back(static_cast<std::uint8_t>(offset & 0xff));
+		out.push_back(static_cast<std::uint8_t>(offset >> 8));
+
+		if (15 <= match_code) {
+
+			put_length(&out, match_code - 15);
+
+		}
+
+		pos += length;
+		anchor = pos;
+
+	}
+
+	// The last sequence only holds the remaining literals.
+	auto literals = size - anchor;
+	out.push_back(static_cast<std::uint8_t>(
+				  (15 < literals ? 15 : literals) << 4));
+
+	if (15 <= literals) {
+
+		put_length(&out, literals - 15);
+
+	}
+
+	out.insert(out.end(), data + anchor, data + size);
+
+	return out;
+
+}
+
+//! Decompress a block of memory.
+/*!
+* Every length and offset is checked against the bounds of the input and the
+* output, so broken data is detected instead of writing out of bounds.
+* \param data Compressed data.
+* \param size Size of the compressed data.
+* \param out Memory to decompress into.
+* \param out_size Size of the uncompressed data.
+* \return True on success, false if the data is broken or does not have the
+* given size uncompressed.
+*/
+bool lz_codec::decompress(const std::uint8_t* data, std::size_t size,
+						  std::uint8_t* out, std::size_t out_size) {
+
+	auto in = data;
+	auto in_end = data + size;
+	std::size_t pos = 0;
+
+	while (in < in_end) {
+
+		auto token = *in++;
+
+		std::size_t literals = token >> 4;
+		if (15 == literals && !get_length(&in, in_end, &literals)) {
+
+			return false;
+
+		}
+
+		if (static_cast<std::size_t>(in_end - in) < literals ||
+			out_size - pos < literals) {
+
+			return false;
+
+		}
+
+		if (0 < literals) {
+
+			std::memcpy(out + pos, in, literals);
+			in += literals;
+
+		}
+
+		pos += literals;
+
+		// The last sequence ends after its literals.
+		if (in_end == in) {
+
+			break;
+
+		}
+
+		if (2 > in_end - in) {
+
+			return false;
+
+		}
+
+		std::size_t offset = in[0] | (static_cast<std::size_t>(in[1]) << 8);
+		in += 2;
+
+		std::size_t length = token & 15;
+		if (15 == length && !get_length(&in, in_end, &length)) {
+
+			return false;
+
+		}
+
+		length += min_match;
+
+		if (0 == offset || pos < offset || out_size - pos < length) {
+
+			return false;
+
+		}
+
+		// Matches may overlap the bytes they produce, so copy byte by byte.
+		auto src = out + pos - offset;
+		for (std::size_t i = 0; i < length; ++ i) {
+
+			out[pos + i] = src[i];
+
+		}
+
+		pos += length;
+
+	}
+
+	return out_size == pos;
+
+}
+
+//! Write the extra bytes of a length.
+/*!
+* \param out Compressed data to append to.
+* \param length Part of the length which did not fit into the token.
+*/
+void lz_codec::put_length(std::vector<std::uint8_t>* out, std::size_t length) {
+
+	while (255 <= length) {
+
+		out->push_back(255);
+		length -= 255;
+
+	}
+
+	out->push_back(static_cast<std::uint8_t>(length));
+
+}
+
+//! Read the extra bytes of a length.
+/*!
+* \param in Position inside the compressed data, moved behind the bytes.
+* \param end End of the compressed data.
+* \param length Length from the token, the extra bytes are added to it.
+* \return True on success, false if the data ends too early.
+*/
+bool lz_codec::get_length(const std::uint8_t** in, const std::uint8_t* end,
+						  std::size_t* length) {
+
+	std::uint8_t extra;
+
+	do {
+
+		if (end == *in) {
+
+			return false;
+
+		}
+
+		extra = *(*in)++;
+		*length += extra;
+
+	} while (255 == extra);
+
+	return true;
+
+}
+
+//! Read four bytes.
+/*!
+* \param data Bytes to read, regardless of their alignment.
+* \return The four bytes as one value.
+*/
+std::uint32_t lz_codec::read32(const std::uint8_t* data) {
+
+	std::uint32_t value;
+	std::memcpy(&value, data, sizeof(value));
+
+	return value;
+
+}
+
+//! Hash four bytes.
+/*!
+* \param value Four bytes read by read32().
+* \return Index into the hash table.
+*/
+std::uint32_t lz_codec::hash32(std::uint32_t value) {
+
+	return (value * 2654435761U) >> (32 - hash_bits);
+
+}
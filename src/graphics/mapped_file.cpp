@@ -0,0 +1,183 @@
+// mapped_file.cpp
+
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Member functions
+
+//! Default constructor.
+/*!
+* Creates an object without a mapped file.
+*/
+#ifdef _WIN32
+mapped_file::mapped_file() : m_data(nullptr), m_size(0), m_mapping(nullptr) {
+}
+#else
+mapped_file::mapped_file() : m_data(nullptr), m_size(0) {
+}
+#endif
+
+//! Default destructor.
+/*!
+* Releases the mapping, if there is one.
+*/
+mapped_file::~mapped_file() {
+
+	close();
+
+}
+
+//! Map a file.
+/*!
+* Maps the whole file read-only into memory. A file which is already mapped by
+* this object is released first. Empty files cannot be mapped.
+* \param filename Path of the file to map.
+* \return True on success.
+*/
+bool mapped_file::open(const std::string& filename) {
+
+	close();
+
+#ifdef _WIN32
+
+	auto file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+							nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+							nullptr);
+	if (INVALID_HANDLE_VALUE == file) {
+
+		return false;
+
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || 0 == size.QuadPart) {
+
+		CloseHandle(file);
+		return false;
+
+	}
+
+	// The mapping object keeps the file open, so its handle is not needed
+	// anymore.
+	m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+
+	if (nullptr == m_mapping) {
+
+		return false;
+
+	}
+
+	m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (nullptr == m_data) {
+
+		CloseHandle(m_mapping);
+		m_mapping = nullptr;
+		return false;
+
+	}
+
+	m_size = static_cast<std::size_t>(size.QuadPart);
+
+#else
+
+	auto file = ::open(filename.c_str(), O_RDONLY);
+	if (-1 == file) {
+
+		return false;
+
+	}
+
+	struct stat info;
+	if (-1 == fstat(file, &info) || 0 == info.st_size) {
+
+		::close(file);
+		return false;
+
+	}
+
+	// The mapping stays valid after the file is closed.
+	auto data = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ,
+					 MAP_PRIVATE, file, 0);
+	::close(file);
+
+	if (MAP_FAILED == data) {
+
+		return false;
+
+	}
+
+	m_data = data;
+	m_size = static_cast<std::size_t>(info.st_size);
+
+#endif
+
+	return true;
+
+}
+
+//! Release the mapping.
+/*!
+* Does nothing if there is no mapped file.
+*/
+void mapped_file::close() {
+
+	if (nullptr == m_data) {
+
+		return;
+
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_data);
+	CloseHandle(m_mapping);
+	m_mapping = nullptr;
+#else
+	munmap(m_data, m_size);
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+
+}
+
+//! Check whether a file is mapped.
+/*!
+* \return True if a file is mapped.
+*/
+bool mapped_file::is_open() const {
+
+	return nullptr != m_data;
+
+}
+
+//! Get the content of the file.
+/*!
+* \return Start of the mapped file, null if there is none.
+*/
+const void* mapped_file::data() const {
+
+	return m_data;
+
+}
+
+//! Get the size of the file.
+/*!
+* \return Size of the mapped file in bytes.
+*/
+std::size_t mapped_file::size() const {
+
+	return m_size;
+
+}
@@ -0,0 +1,370 @@
+// preloader.cpp
+
+#include "preloader.hpp"
+#include "worker_pool.hpp"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <future>
+
+// Member functions
+
+//! Default constructor.
+/*!
+* Creates a preloader without any resources. The time to the first frame is
+* measured from here on.
+*/
+preloader::preloader() : m_assets(), m_clock(), m_load_time(),
+	m_first_frame() {
+}
+
+//! Read a manifest.
+/*!
+* Adds all resources listed inside the manifest, see the class description for
+* its format. Nothing is loaded until load() is called.
+* \param filename Path of the manifest.
+* \return True on success, false if the manifest could not be read or holds an
+* invalid line.
+*/
+bool preloader::manifest(const std::string& filename) {
+
+	std::ifstream file(filename);
+	if (!file) {
+
+		std::cerr << "Could not open manifest " << filename << "\n";
+		return false;
+
+	}
+
+	std::string line;
+	for (unsigned int number = 1; std::getline(file, line); ++ number) {
+
+		std::istringstream fields(line);
+		std::string type, name, path;
+
+		// Skip empty lines and comments.
+		if (!(fields >> type) || '#' == type[0]) {
+
+			continue;
+
+		}
+
+		auto valid = static_cast<bool>(fields >> name >> path);
+		kind res_kind = FONT;
+
+		if ("font" == type) {
+
+			res_kind = FONT;
+
+		} else if ("image" == type) {
+
+			res_kind = IMAGE;
+
+		} else if ("texture" == type) {
+
+			res_kind = TEXTURE;
+
+		} else if ("atlas" == type) {
+
+			res_kind = ATLAS;
+
+		} else {
+
+			valid = false;
+
+		}
+
+		// Options.
+		sf::IntRect area;
+		sf::Vector2u size;
+		std::string option;
+		while (valid && fields >> option) {
+
+			char sep[3];
+			std::istringstream value(option.substr(option.find('=') + 1));
+
+			if (0 == option.compare(0, 5, "area=")) {
+
+				valid = static_cast<bool>(value >> area.left >> sep[0] >>
+										  area.top >> sep[1] >> area.width >>
+										  sep[2] >> area.height);
+
+			} else if ("size=desktop" == option) {
+
+				auto desktop = sf::VideoMode::getDesktopMode();
+				size = sf::Vector2u(desktop.width, desktop.height);
+
+			} else if (0 == option.compare(0, 5, "size=")) {
+
+				valid = static_cast<bool>(value >> size.x >> sep[0] >> size.y);
+
+			} else {
+
+				valid = false;
+
+			}
+
+		}
+
+		if (!valid) {
+
+			std::cerr << "Invalid line " << number << " in manifest " <<
+						 filename << "\n";
+			return false;
+
+		}
+
+		add(res_kind, name, path, area, size);
+
+	}
+
+	return true;
+
+}
+
+//! Add a resource.
+/*!
+* \param type Kind of the resource.
+* \param name Name to find the resource by.
+* \param path Path of the file.
+* \param area Area of the image to load, empty for the whole image.
+* \param size Size to scale a texture down to, zero to keep its size.
+*/
+void preloader::add(kind type, const std::string& name, const std::string& path,
+					const sf::IntRect& area, const sf::Vector2u& size) {
+
+	asset item;
+	item.type = type;
+	item.name = name;
+	item.path = path;
+	item.area = area;
+	item.size = size;
+	item.loaded = false;
+
+	m_assets.push_back(item);
+
+}
+
+//! Load all resources.
+/*!
+* Decodes all resources at the same time on the shared worker_pool. The
+* calling thread uploads the textures in the order of the manifest, each as
+* soon as it has been decoded, so the uploads overlap with the decoding of the
+* resources further down.
+*
+* NOTE: Has to be called from the render thread.
+* \return True if all resources have been loaded.
+*/
+bool preloader::load() {
+
+	sf::Clock clock;
+
+	std::vector<std::future<sf::Time>> decoded;
+	decoded.reserve(m_assets.size());
+
+	// The list is not changed until all tasks are done, so the workers can
+	// hold on to the resources.
+	for (auto& item : m_assets) {
+
+		auto target = &item;
+		decoded.push_back(worker_pool::shared().submit([target]() {
+
+			sf::Clock decode_clock;
+			decode(*target);
+
+			return decode_clock.getElapsedTime();
+
+		}));
+
+	}
+
+	auto all_loaded = true;
+
+	for (std::size_t i = 0; i < m_assets.size(); ++ i) {
+
+		auto& item = m_assets[i];
+		item.decode_time = decoded[i].get();
+
+		sf::Clock upload_clock;
+		item.loaded = upload(item);
+		item.upload_time = upload_clock.getElapsedTime();
+
+		if (!item.loaded) {
+
+			std::cerr << "Could not load " << item.path << "\n";
+			all_loaded = false;
+
+		}
+
+	}
+
+	m_load_time = clock.getElapsedTime();
+
+	return all_loaded;
+
+}
+
+//! Find a resource.
+/*!
+* \param name Name of the resource.
+* \return Resource with the name, null if there is none.
+*/
+const preloader::asset* preloader::find(const std::string& name) const {
+
+	for (auto& item : m_assets) {
+
+		if (name == item.name) {
+
+			return &item;
+
+		}
+
+	}
+
+	return nullptr;
+
+}
+
+//! Get all resources.
+/*!
+* \return All resources, in the order they have been added.
+*/
+const std::vector<preloader::asset>& preloader::assets() const {
+
+	return m_assets;
+
+}
+
+//! Mark the first frame.
+/*!
+* Records the time since the construction of the preloader. Should be called
+* right after the first frame has been displayed.
+*/
+void preloader::first_frame() {
+
+	m_first_frame = m_clock.getElapsedTime();
+
+}
+
+//! Print the load times.
+/*!
+* Prints the decode and upload time of each resource, the time load() took and
+* the time to the first frame, if it has been marked.
+* \param out Stream to print to.
+*/
+void preloader::report(std::ostream& out) const {
+
+	for (auto& item : m_assets) {
+
+		out << item.name << ": decode " <<
+			   item.decode_time.asMicroseconds() / 1000.f << " ms, upload " <<
+			   item.upload_time.asMicroseconds() / 1000.f << " ms" <<
+			   (item.loaded ? "" : " (failed)") << "\n";
+
+	}
+
+	out << "Preload: " << m_load_time.asMicroseconds() / 1000.f << " ms on " <<
+		   worker_pool::shared().size() << " threads\n";
+
+	if (sf::Time::Zero != m_first_frame) {
+
+		out << "Time to first frame: " <<
+			   m_first_frame.asMicroseconds() / 1000.f << " ms\n";
+
+	}
+
+}
+
+//! Decode a resource.
+/*!
+* Does the CPU side of loading the resource. Fonts and images are loaded
+* completely, textures are decoded, see texture_repository::decode().
+*
+* NOTE: Runs on the worker_pool, so it must not touch any texture.
+* \param item Resource to decode.
+*/
+void preloader::decode(asset& item) {
+
+	switch (item.type) {
+
+		case FONT :
+
+			item.font = std::make_shared<sf::Font>();
+			if (!item.font->loadFromFile(item.path)) {
+
+				item.font = nullptr;
+
+			}
+			break;
+
+		case IMAGE :
+		case TEXTURE :
+
+			item.image = texture_repository::decode(item.path, item.area,
+													item.size);
+			break;
+
+		case ATLAS :
+
+			// Images inside the atlas are never scaled.
+			item.image = texture_repository::decode(item.path, item.area);
+			break;
+
+	}
+
+}
+
+//! Upload a decoded resource.
+/*!
+* Uploads decoded textures through the texture_repository. The decoded image
+* of a texture is released afterwards.
+*
+* NOTE: Has to be called from the render thread.
+* \param item Resource to upload.
+* \return True if the resource has been loaded.
+*/
+bool preloader::upload(asset& item) {
+
+	switch (item.type) {
+
+		case FONT :
+
+			return nullptr != item.font;
+
+		case IMAGE :
+
+			return nullptr != item.image;
+
+		case TEXTURE :
+		case ATLAS :
+
+			break;
+
+	}
+
+	if (nullptr == item.image) {
+
+		return false;
+
+	}
+
+	auto loaded = (TEXTURE == item.type) ?
+				  texture_repository::load_decoded(&item.tex, item.path,
+												   *item.image, item.area,
+												   item.size) :
+				  texture_repository::load_atlas(&item.tex, &item.rect,
+												 item.path, *item.image,
+												 item.area);
+
+	if (loaded && TEXTURE == item.type) {
+
+		auto size = texture_repository::size(item.tex);
+		item.rect = sf::IntRect(0, 0, size.x, size.y);
+
+	}
+
+	item.image = nullptr;
+
+	return loaded;
+
+}
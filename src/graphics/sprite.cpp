@@ -68,16 +68,12 @@ Sprite::Sprite(const sf::Texture& texture, const sf::IntRect& rect) {
 
 }
 
-//! Texture destructing destructor.
+//! Default destructor.
 /*!
-* The purpose of this destructor is to delete the reference to
-* the texture held by this object. Afterwards call the texture
-* destructing function.
+* Releasing the reference to the texture is enough, the texture repository
+* deletes the texture once its last reference is gone.
 */
 Sprite::~Sprite(void) {
-
-	texture_repository::tidy();
-
 }
 
 //! Set the render rectangle, which the sprite will display.
@@ -119,13 +115,14 @@ sf::FloatRect Sprite::loc_bound() const {
 //! Update the vertices' texture coordinates.
 /*!
 * The coordinates are retrieved by the texture rect member and
-* assigned anticlockwise.
+* assigned anticlockwise. The texture rect is relative to the area of the
+* texture holding the image.
 */
 void Sprite::updateTexCoords() {
 
-    float left   = static_cast<float>(mTexRect.left) ;
+    float left   = static_cast<float>(m_tex_area.left + mTexRect.left) ;
     float right  = left + mTexRect.width ;
-    float top    = static_cast<float>(mTexRect.top) ;
+    float top    = static_cast<float>(m_tex_area.top + mTexRect.top) ;
     float bottom = top + mTexRect.height ;
 
 	// Coordinates, defined anticlockwise.
@@ -155,6 +152,9 @@ void Sprite::draw(sf::RenderTarget& target, sf::RenderStates states) const {
     std::cout << m_texture.use_count();
     std::cin.get();*/
 
+        // Restores the texture if it has been evicted.
+        texture_repository::touch(m_texture);
+
         states.texture = m_texture.get();
         target.draw(m_vertices, 4, sf::Quads, states);
     }
@@ -0,0 +1,593 @@
+// sprite_sheet.cpp
+
+#include "sprite_sheet.hpp"
+#include "mapped_file.hpp"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstring>
+
+// Member variables
+
+//! Version of the binary form.
+const std::uint32_t sprite_sheet::version;
+
+//! Number of 32 bit values of the header, including the magic.
+const std::size_t sprite_sheet::header_values;
+
+//! Number of 32 bit values of an entry.
+const std::size_t sprite_sheet::entry_values;
+
+//! Number of 32 bit values of a clip.
+const std::size_t sprite_sheet::clip_values;
+
+//! Longest frame duration in ms, the range of sf::milliseconds().
+const std::uint32_t sprite_sheet::max_duration;
+
+//! Most frames the binary form may hold.
+const std::size_t sprite_sheet::max_frames;
+
+// Member functions
+
+//! Default constructor.
+/*!
+* Creates a sprite sheet without any frames.
+*/
+sprite_sheet::sprite_sheet() : m_entries(), m_frames(), m_durations(),
+	m_clips() {
+}
+
+//! Load the binary form.
+/*!
+* Maps the file and expands the groups in a single pass, see the class
+* description for its format. Every count is checked against the size of the
+* file before anything is read or allocated, so a broken file is rejected
+* instead of being read out of bounds. The frame count is limited to
+* max_frames, so a broken header cannot request a huge allocation either. The
+* frames loaded before are removed.
+* \param filename Path of the binary form.
+* \return True on success, false if the file could not be mapped or is broken.
+* The sprite sheet is empty in that case.
+*/
+bool sprite_sheet::load(const std::string& filename) {
+
+	clear();
+
+	mapped_file file;
+	if (!file.open(filename)) {
+
+		std::cerr << "Could not open sprite sheet " << filename << "\n";
+		return false;
+
+	}
+
+	auto data = static_cast<const std::uint8_t*>(file.data());
+	auto size = file.size();
+
+	auto invalid = [this, &filename]() {
+
+		clear();
+		std::cerr << "Invalid sprite sheet " << filename << "\n";
+
+		return false;
+
+	};
+
+	if (header_values * 4 > size || 0 != std::memcmp(data, "WOSS", 4) ||
+		version != read32(data + 4)) {
+
+		return invalid();
+
+	}
+
+	std::size_t entry_count = read32(data + 8);
+	std::size_t clip_count = read32(data + 12);
+	std::size_t frame_count = read32(data + 16);
+	std::size_t name_size = read32(data + 20);
+
+	// Each count is below 2^32, so the sum cannot overflow 64 bit.
+	auto expected = static_cast<std::uint64_t>(header_values) * 4 +
+					static_cast<std::uint64_t>(entry_count) * entry_values * 4 +
+					static_cast<std::uint64_t>(clip_count) * clip_values * 4 +
+					name_size;
+
+	// The frame count is only limited by max_frames, not by the size of the
+	// file, since a few groups can expand to any number of frames.
+	if (expected != size || max_frames < frame_count) {
+
+		return invalid();
+
+	}
+
+	auto entries = data + header_values * 4;
+	auto group = [entries](std::size_t index) {
+
+		auto pos = entries + index * entry_values * 4;
+
+		return frame_group(static_cast<std::int32_t>(read32(pos)),
+						   static_cast<std::int32_t>(read32(pos + 4)),
+						   static_cast<std::int32_t>(read32(pos + 8)),
+						   static_cast<std::int32_t>(read32(pos + 12)),
+						   static_cast<std::int32_t>(read32(pos + 16)),
+						   static_cast<std::int32_t>(read32(pos + 20)));
+
+	};
+
+	// The groups have to hold as many frames as announced by the header. This
+	// is checked before anything is allocated.
+	std::size_t cell_count = 0;
+	for (std::size_t i = 0; i < entry_count; ++ i) {
+
+		auto group_cells = cells(group(i));
+		if (frame_count - cell_count < group_cells) {
+
+			return invalid();
+
+		}
+
+		cell_count += group_cells;
+
+	}
+
+	if (frame_count != cell_count) {
+
+		return invalid();
+
+	}
+
+	m_entries.reserve(entry_count);
+	m_frames.reserve(frame_count);
+	m_durations.reserve(frame_count);
+
+	for (std::size_t i = 0; i < entry_count; ++ i) {
+
+		entry item;
+		item.group = group(i);
+		item.duration = read32(entries + i * entry_values * 4 + 24);
+
+		if (max_duration < item.duration) {
+
+			return invalid();
+
+		}
+
+		expand(item);
+
+	}
+
+	auto pos = entries + entry_count * entry_values * 4;
+	auto names = reinterpret_cast<const char*>(pos + clip_count * clip_values *
+											   4);
+	std::size_t name_pos = 0;
+
+	for (std::size_t i = 0; i < clip_count; ++ i, pos += clip_values * 4) {
+
+		std::size_t length = read32(pos + 8);
+
+		if (name_size - name_pos < length ||
+			!add_clip(std::string(names + name_pos, length), read32(pos),
+					  read32(pos + 4))) {
+
+			return invalid();
+
+		}
+
+		name_pos += length;
+
+	}
+
+	return true;
+
+}
+
+//! Load the text form.
+/*!
+* Reads the descriptor line by line, see the class description for its format.
+* The frames loaded before are removed.
+* \param filename Path of the text form.
+* \return True on success, false if the file could not be read or holds an
+* invalid line. The sprite sheet is empty in that case.
+*/
+bool sprite_sheet::load_text(const std::string& filename) {
+
+	clear();
+
+	std::ifstream file(filename);
+	if (!file) {
+
+		std::cerr << "Could not open sprite sheet " << filename << "\n";
+		return false;
+
+	}
+
+	std::string line;
+	for (unsigned int number = 1; std::getline(file, line); ++ number) {
+
+		std::istringstream fields(line);
+		std::string type;
+
+		// Skip empty lines and comments.
+		if (!(fields >> type) || '#' == type[0]) {
+
+			continue;
+
+		}
+
+		// Read signed, so negative durations are rejected instead of wrapping
+		// around.
+		auto valid = false;
+		long long duration = 0;
+
+		if ("frame" == type) {
+
+			frame frm;
+			valid = static_cast<bool>(fields >> frm.x >> frm.y >> frm.w >>
+									  frm.h);
+
+			if (valid && (fields >> duration || fields.eof()) &&
+				0 <= duration && duration <= max_duration) {
+
+				add(frm, sf::milliseconds(static_cast<sf::Int32>(duration)));
+
+			} else {
+
+				valid = false;
+
+			}
+
+		} else if ("group" == type) {
+
+			frame_group frm_grp;
+			valid = static_cast<bool>(fields >> frm_grp.x >> frm_grp.y >>
+									  frm_grp.sw >> frm_grp.sh >> frm_grp.w >>
+									  frm_grp.h) &&
+					0 < frm_grp.w && 0 < frm_grp.h;
+
+			if (valid && (fields >> duration || fields.eof()) &&
+				0 <= duration && duration <= max_duration) {
+
+				add(frm_grp,
+					sf::milliseconds(static_cast<sf::Int32>(duration)));
+
+			} else {
+
+				valid = false;
+
+			}
+
+		} else if ("clip" == type) {
+
+			std::string name;
+			std::size_t first, count;
+			valid = static_cast<bool>(fields >> name >> first >> count) &&
+					add_clip(name, first, count);
+
+		}
+
+		// Nothing may follow the fields.
+		std::string rest;
+		if (!valid || fields >> rest) {
+
+			std::cerr << "Invalid line " << number << " in sprite sheet " <<
+						 filename << "\n";
+			clear();
+			return false;
+
+		}
+
+	}
+
+	return true;
+
+}
+
+//! Save the binary form.
+/*!
+* \param filename Path of the binary form, an existing file is overwritten.
+* \return True on success.
+*/
+bool sprite_sheet::save(const std::string& filename) const {
+
+	std::vector<std::uint8_t> out;
+	std::string names;
+
+	out.insert(out.end(), {'W', 'O', 'S', 'S'});
+	put32(&out, version);
+	put32(&out, static_cast<std::uint32_t>(m_entries.size()));
+	put32(&out, static_cast<std::uint32_t>(m_clips.size()));
+	put32(&out, static_cast<std::uint32_t>(m_frames.size()));
+
+	for (auto& item : m_clips) {
+
+		names += item.name;
+
+	}
+
+	put32(&out, static_cast<std::uint32_t>(names.size()));
+
+	for (auto& item : m_entries) {
+
+		for (auto value : {item.group.x, item.group.y, item.group.sw,
+						   item.group.sh, item.group.w, item.group.h}) {
+
+			put32(&out, static_cast<std::uint32_t>(value));
+
+		}
+
+		put32(&out, item.duration);
+
+	}
+
+	for (auto& item : m_clips) {
+
+		put32(&out, static_cast<std::uint32_t>(item.first));
+		put32(&out, static_cast<std::uint32_t>(item.count));
+		put32(&out, static_cast<std::uint32_t>(item.name.size()));
+
+	}
+
+	out.insert(out.end(), names.begin(), names.end());
+
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(out.data()), out.size());
+
+	if (!file) {
+
+		std::cerr << "Could not write sprite sheet " << filename << "\n";
+		return false;
+
+	}
+
+	return true;
+
+}
+
+//! Convert the text form into the binary form.
+/*!
+* \param text_file Path of the text form.
+* \param binary_file Path of the binary form, an existing file is overwritten.
+* \return True on success.
+*/
+bool sprite_sheet::convert(const std::string& text_file,
+						   const std::string& binary_file) {
+
+	sprite_sheet sheet;
+
+	return sheet.load_text(text_file) && sheet.save(binary_file);
+
+}
+
+//! Add a frame.
+/*!
+* \param frm Frame to add.
+* \param duration Duration of the frame, zero (or less) for the default
+* duration of the animation.
+*/
+void sprite_sheet::add(const frame& frm, sf::Time duration) {
+
+	entry item;
+	item.group = frame_group(frm.x, frm.y, frm.w, frm.h, frm.w, frm.h);
+	item.duration = to_ms(duration);
+
+	expand(item);
+
+}
+
+//! Add all frames of a frame group.
+/*!
+* The frames are added row by row, like by animation::insert().
+* \param frm_grp Frame group to add.
+* \param duration Duration of each frame, zero (or less) for the default
+* duration of the animation.
+*/
+void sprite_sheet::add(const frame_group& frm_grp, sf::Time duration) {
+
+	entry item;
+	item.group = frm_grp;
+	item.duration = to_ms(duration);
+
+	expand(item);
+
+}
+
+//! Add a clip.
+/*!
+* \param name Name of the clip.
+* \param first Index of the first frame.
+* \param count Number of frames.
+* \return True on success, false if the range is not inside the frames.
+*/
+bool sprite_sheet::add_clip(const std::string& name, std::size_t first,
+							std::size_t count) {
+
+	if (m_frames.size() < count || m_frames.size() - count < first) {
+
+		return false;
+
+	}
+
+	clip item;
+	item.name = name;
+	item.first = first;
+	item.count = count;
+
+	m_clips.push_back(item);
+
+	return true;
+
+}
+
+//! Remove all frames and clips.
+void sprite_sheet::clear() {
+
+	m_entries.clear();
+	m_frames.clear();
+	m_durations.clear();
+	m_clips.clear();
+
+}
+
+//! Get the frames.
+/*!
+* \return Frames of all groups, in the order of the descriptor.
+*/
+const std::vector<frame>& sprite_sheet::frames() const {
+
+	return m_frames;
+
+}
+
+//! Get the frame durations.
+/*!
+* \return Duration of each frame, zero for the default duration of the
+* animation.
+*/
+const std::vector<sf::Time>& sprite_sheet::durations() const {
+
+	return m_durations;
+
+}
+
+//! Get the clips.
+/*!
+* \return Clips, in the order of the descriptor.
+*/
+const std::vector<sprite_sheet::clip>& sprite_sheet::clips() const {
+
+	return m_clips;
+
+}
+
+//! Find a clip.
+/*!
+* \param name Name of the clip.
+* \return Clip with the name, null if there is none.
+*/
+const sprite_sheet::clip* sprite_sheet::find(const std::string& name) const {
+
+	for (auto& item : m_clips) {
+
+		if (name == item.name) {
+
+			return &item;
+
+		}
+
+	}
+
+	return nullptr;
+
+}
+
+//! Convert a frame duration for an entry.
+/*!
+* \param duration Duration of a frame.
+* \return Duration in ms, zero if it is negative.
+*/
+std::uint32_t sprite_sheet::to_ms(sf::Time duration) {
+
+	auto ms = duration.asMilliseconds();
+
+	return (0 < ms) ? static_cast<std::uint32_t>(ms) : 0;
+
+}
+
+//! Number of frames of a group.
+/*!
+* A group whose section has the size of its frames is a single frame, even if
+* the frames are flipped or empty.
+* \param frm_grp Frame group.
+* \return Number of frames inside the group.
+*/
+std::size_t sprite_sheet::cells(const frame_group& frm_grp) {
+
+	if (frm_grp.sw == frm_grp.w && frm_grp.sh == frm_grp.h) {
+
+		return 1;
+
+	}
+
+	if (0 >= frm_grp.w || 0 >= frm_grp.h || 0 > frm_grp.sw ||
+		0 > frm_grp.sh) {
+
+		return 0;
+
+	}
+
+	return static_cast<std::size_t>(frm_grp.sh / frm_grp.h) *
+		   static_cast<std::size_t>(frm_grp.sw / frm_grp.w);
+
+}
+
+//! Add a group and its frames.
+/*!
+* \param item Group to add.
+*/
+void sprite_sheet::expand(const entry& item) {
+
+	auto& grp = item.group;
+	auto duration = sf::milliseconds(static_cast<sf::Int32>(item.duration));
+
+	m_entries.push_back(item);
+
+	if (1 == cells(grp)) {
+
+		m_frames.push_back(frame(grp.x, grp.y, grp.w, grp.h));
+		m_durations.push_back(duration);
+		return;
+
+	}
+
+	if (0 == cells(grp)) {
+
+		return;
+
+	}
+
+	// Calculate how many rows and colums are inside the frame group.
+	auto rows = grp.sh / grp.h;
+	auto cols = grp.sw / grp.w;
+
+	for (int i = 0; i < rows; ++ i) {
+
+		for (int j = 0; j < cols; ++ j) {
+
+			m_frames.push_back(frame(grp.x + j * grp.w, grp.y + i * grp.h,
+									 grp.w, grp.h));
+
+		}
+
+	}
+
+	m_durations.resize(m_frames.size(), duration);
+
+}
+
+//! Read a little endian 32 bit value.
+/*!
+* \param data Bytes to read, regardless of their alignment.
+* \return The value.
+*/
+std::uint32_t sprite_sheet::read32(const std::uint8_t* data) {
+
+	return static_cast<std::uint32_t>(data[0]) |
+		   (static_cast<std::uint32_t>(data[1]) << 8) |
+		   (static_cast<std::uint32_t>(data[2]) << 16) |
+		   (static_cast<std::uint32_t>(data[3]) << 24);
+
+}
+
+//! Append a little endian 32 bit value.
+/*!
+* \param out Data to append to.
+* \param value Value to append.
+*/
+void sprite_sheet::put32(std::vector<std::uint8_t>* out, std::uint32_t value) {
+
+	for (unsigned int shift = 0; shift < 32; shift += 8) {
+
+		out->push_back(static_cast<std::uint8_t>(value >> shift));
+
+	}
+
+}
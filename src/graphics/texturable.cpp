@@ -28,6 +28,7 @@
 #include <SFML/Graphics/Texture.hpp>
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <cstdlib>
+#include <chrono>
 #include "texturable.hpp"
 
 //! Load a texture from file into the sprite.
@@ -35,24 +36,47 @@
 * Loads a texture object from a file and stores a pointer to it
 * inside of the sprite. With the two last arguments, it can be specified how
 * much of the image should be loaded, and how much of the loaded content should
-* be displayed.
+* be displayed. An area which is not scaled is loaded as view of the whole
+* image, see texture_repository::load_view().
 * \param filename Name of the file from which to load.
 * \param displ_rect Area of texture (applied load_rect) to display.
 * \param load_rect Area of image (file) to load.
+* \param tex_size Size to scale the loaded area down to, zero to keep its size.
+* The display rectangle refers to the scaled texture.
 * \return True on success.
 */
 /* \todo Apply the better style of the load function (below) to all other
 load functions */
 bool Textureable::load(const std::string& filename,
 					   const sf::IntRect& displ_rect,
-					   const sf::IntRect& load_rect) {
+					   const sf::IntRect& load_rect,
+					   const sf::Vector2u& tex_size) {
+
+	// Areas of the file are views of the whole file, unless they are scaled.
+	auto view = sf::IntRect() != load_rect && sf::Vector2u() == tex_size;
+	auto loaded = view ?
+				  texture_repository::load_view(&this->m_texture,
+												&this->m_tex_area, filename,
+												load_rect) :
+				  texture_repository::load(&this->m_texture, filename,
+										   load_rect, tex_size);
 
-    if (!texture_repository::load(&this->m_texture, filename, load_rect)) {
+    if (!loaded) {
 
         return false;
 
     }
 
+	if (!view) {
+
+		m_tex_area = sf::IntRect();
+
+	}
+
+	// Force the texture coordinates to be updated, since they depend on the
+	// area, too.
+	mTexRect = sf::IntRect();
+
 	// THIS LINE CAUSE THE SPRITE NOT TO APPEAR ON SCREEN. UNCOMMENT IT TO FIX
 	// THE ERROR.
 	//setTexture(*(m_texture.get()));
@@ -68,23 +92,44 @@ bool Textureable::load(const std::string& filename,
 * Loads a texture object from a file in memory and stores a pointer to it
 * inside of the sprite. With the two last arguments, it can be specified how
 * much of the image should be loaded, and how much of the loaded content should
-* be displayed.
+* be displayed. An area which is not scaled is loaded as view of the whole
+* image, see texture_repository::load_view().
 * \param data Data in memory from which to load.
 * \param size Size of the block of data.
 * \param displ_rect Area of texture (applied load_rect) to display.
 * \param load_rect Area of image (file) to load.
+* \param tex_size Size to scale the loaded area down to, zero to keep its size.
+* The display rectangle refers to the scaled texture.
 * \return True on success.
 */
 bool Textureable::load(const void* data, std::size_t size,
 					   const sf::IntRect& displ_rect,
-					   const sf::IntRect& load_rect) {
+					   const sf::IntRect& load_rect,
+					   const sf::Vector2u& tex_size) {
+
+	// Areas of the file are views of the whole file, unless they are scaled.
+	auto view = sf::IntRect() != load_rect && sf::Vector2u() == tex_size;
+	auto loaded = view ?
+				  texture_repository::load_view(&this->m_texture,
+												&this->m_tex_area, data, size,
+												load_rect) :
+				  texture_repository::load(&this->m_texture, data, size,
+										   load_rect, tex_size);
 
-    if (!texture_repository::load(&this->m_texture, data, size, load_rect)) {
+    if (!loaded) {
 
         return false;
 
     }
 
+	if (!view) {
+
+		m_tex_area = sf::IntRect();
+
+	}
+
+	mTexRect = sf::IntRect();
+
 	appl_displ_rect(displ_rect);
 
 	return true;
@@ -100,17 +145,24 @@ bool Textureable::load(const void* data, std::size_t size,
 * \param stream Custom stream from which to load.
 * \param displ_rect Area of texture (applied load_rect) to display.
 * \param load_rect Area of image (file) to load.
+* \param tex_size Size to scale the loaded area down to, zero to keep its size.
+* The display rectangle refers to the scaled texture.
 * \return True on success.
 */
 bool Textureable::load(sf::InputStream& stream, const sf::IntRect& displ_rect,
-					   const sf::IntRect& load_rect) {
+					   const sf::IntRect& load_rect,
+					   const sf::Vector2u& tex_size) {
 
-    if (!texture_repository::load(&this->m_texture, stream, load_rect)) {
+    if (!texture_repository::load(&this->m_texture, stream, load_rect,
+								  tex_size)) {
 
         return false;
 
     }
 
+	m_tex_area = sf::IntRect();
+	mTexRect = sf::IntRect();
+
 	appl_displ_rect(displ_rect);
 
 	return true;
@@ -122,22 +174,135 @@ bool Textureable::load(sf::InputStream& stream, const sf::IntRect& displ_rect,
 * Loads a texture object from an image and stores a pointer to it
 * inside of the sprite. With the two last arguments, it can be specified how
 * much of the image should be loaded, and how much of the loaded content should
-* be displayed.
+* be displayed. An area which is not scaled is loaded as view of the whole
+* image, see texture_repository::load_view().
 * \param image Image from which to load.
 * \param displ_rect Area of texture (applied load_rect) to display.
 * \param load_rect Area of image (file) to load.
+* \param tex_size Size to scale the loaded area down to, zero to keep its size.
+* The display rectangle refers to the scaled texture.
 * \return True on success.
 */
 bool Textureable::load(const sf::Image& image, 
 					   const sf::IntRect& displ_rect,
-					   const sf::IntRect& load_rect) {
+					   const sf::IntRect& load_rect,
+					   const sf::Vector2u& tex_size) {
 
-    if (!texture_repository::load(&this->m_texture, image, load_rect)) {
+	// Areas of the image are views of the whole image, unless they are scaled.
+	auto view = sf::IntRect() != load_rect && sf::Vector2u() == tex_size;
+	auto loaded = view ?
+				  texture_repository::load_view(&this->m_texture,
+												&this->m_tex_area, image,
+												load_rect) :
+				  texture_repository::load(&this->m_texture, image, load_rect,
+										   tex_size);
+
+    if (!loaded) {
 
         return false;
 
     }
 
+	if (!view) {
+
+		m_tex_area = sf::IntRect();
+
+	}
+
+	mTexRect = sf::IntRect();
+
+	appl_displ_rect(displ_rect);
+
+	return true;
+
+}
+
+//! Load a texture from file asynchronously.
+/*!
+* Starts to load the texture in the background, see
+* texture_repository::load_async(). Until the texture is uploaded, the
+* placeholder texture is displayed. Since the size of the texture is not known
+* before, the display rectangle is applied once more by sync(), which should
+* be called after texture_repository::upload_pending().
+* \param filename Name of the file from which to load.
+* \param displ_rect Area of texture (applied load_rect) to display.
+* \param load_rect Area of image (file) to load.
+* \param tex_size Size to scale the loaded area down to, zero to keep its size.
+* The display rectangle refers to the scaled texture.
+* \return Future which becomes true once the texture has been uploaded.
+*/
+std::shared_future<bool> Textureable::load_async(const std::string& filename,
+									const sf::IntRect& displ_rect,
+									const sf::IntRect& load_rect,
+									const sf::Vector2u& tex_size) {
+
+	m_pending = texture_repository::load_async(&this->m_texture, filename,
+											   load_rect, tex_size);
+	m_pending_rect = displ_rect;
+	m_tex_area = sf::IntRect();
+
+	appl_displ_rect(displ_rect);
+
+	return m_pending;
+
+}
+
+//! Synchronize with a pending asynchronous load.
+/*!
+* Checks whether the texture of the last load_async() call has been uploaded.
+* If so, the display rectangle is applied to the real texture.
+* \return True if the pending load has been finished successfully by this
+* call, false if there is none, it is still pending or it has failed.
+*/
+bool Textureable::sync() {
+
+	if (!m_pending.valid() || std::future_status::ready !=
+		m_pending.wait_for(std::chrono::seconds(0))) {
+
+		return false;
+
+	}
+
+	auto loaded = m_pending.get();
+	m_pending = std::shared_future<bool>();
+
+	if (loaded) {
+
+		// Force the texture coordinates to be updated, even if the rectangle
+		// stays the same.
+		mTexRect = sf::IntRect();
+		appl_displ_rect(m_pending_rect);
+
+	}
+
+	return loaded;
+
+}
+
+//! Load a texture from file into the atlas.
+/*!
+* Loads the image into a page of the atlas, which is shared with other small
+* images, see texture_repository::load_atlas(). Objects sharing a page can be
+* drawn without rebinding the texture.
+* \param filename Name of the file from which to load.
+* \param displ_rect Area of texture (applied load_rect) to display.
+* \param load_rect Area of image (file) to load.
+* \return True on success.
+*/
+bool Textureable::load_atlas(const std::string& filename,
+							 const sf::IntRect& displ_rect,
+							 const sf::IntRect& load_rect) {
+
+	if (!texture_repository::load_atlas(&this->m_texture, &this->m_tex_area,
+										filename, load_rect)) {
+
+		return false;
+
+	}
+
+	// Force the texture coordinates to be updated, since they depend on the
+	// area, too.
+	mTexRect = sf::IntRect();
 	appl_displ_rect(displ_rect);
 
 	return true;
@@ -151,6 +316,10 @@ bool Textureable::load(const sf::Image& image,
 * the source texture is hold inside this class, but not a copy. If
 * the texture is destroyed anyway, the behaviour is undefined.
 *
+* If the texture is held by the texture_repository, the sprite shares it
+* like any loaded texture, so it stays alive as long as the sprite uses it.
+* Otherwise the pointer does not own the texture.
+*
 * If the seconds parameter is true, the internal render rectangle
 * is adjusted to the size of the new texture; otherwise left
 * unchanged.
@@ -159,15 +328,58 @@ bool Textureable::load(const sf::Image& image,
 * \sa setTexRect
 */
 void Textureable::setTexture(const sf::Texture& texture, bool reset_rect)
+{
+
+	auto shared = texture_repository::find(&texture);
+	if (nullptr == shared) {
+
+		// Alias the texture without owning it. Copying it instead would read
+		// the pixels back from the graphics card and upload them again.
+		shared = texture_ptr(texture_ptr(), const_cast<sf::Texture*>(&texture));
+
+	}
+
+	setTexture(shared, reset_rect);
+
+}
+
+//! Change the source texture to a shared one.
+/*!
+* The sprite shares the ownership of the texture, so it stays alive as long
+* as the sprite uses it. A null pointer removes the texture, the sprite is not
+* drawn then.
+*
+* If the seconds parameter is true, the internal render rectangle
+* is adjusted to the size of the new texture; otherwise left
+* unchanged.
+* \param texture New source texture, may be null.
+* \param If true, the visible (drawn) rectangle is adjusted.
+* \sa setTexRect
+*/
+void Textureable::setTexture(const texture_ptr& texture, bool reset_rect)
 {
 
     // Recompute the texture area if requested, or if there is a valid texture,
-    // but there has not been a rect before.
-	if (reset_rect || (nullptr != m_texture && (mTexRect == sf::IntRect())))
-        setTexRect(sf::IntRect(0, 0, texture.getSize().x, texture.getSize().y));
+    // but there has not been a rect before. Without a new texture, there is
+    // no size to take it from.
+	auto rect = mTexRect;
+	if (nullptr != texture && (reset_rect ||
+		(nullptr != m_texture && (mTexRect == sf::IntRect())))) {
+
+		auto size = texture_repository::size(texture);
+        rect = sf::IntRect(0, 0, size.x, size.y);
+
+	}
+
+    // Assign the new texture first, since the texture coordinates depend on
+    // it and on its area.
+    m_texture = texture;
+	m_tex_area = sf::IntRect();
 
-    // Assign the new texture.
-    m_texture = std::make_shared<sf::Texture>(texture);
+	// Force the texture coordinates to be updated, even if the rectangle stays
+	// the same, the area of a previous atlas or view may still be added.
+	mTexRect = sf::IntRect();
+	setTexRect(rect);
 
 }
 
@@ -309,8 +521,7 @@ void Textureable::appl_displ_rect(const sf::IntRect& displ_rect) {
 		
 		// If there is no display rectangle set, create one as big as the
 		// texture.
-		setTexRect(sf::IntRect(0, 0, 
-							   m_texture->getSize().x, m_texture->getSize().y));
+		setTexRect(sf::IntRect(0, 0, tex_size().x, tex_size().y));
 
 	} else {
 			
@@ -319,3 +530,23 @@ void Textureable::appl_displ_rect(const sf::IntRect& displ_rect) {
 	}
 
 }
+
+//! Get the size of the image.
+/*!
+* Returns the size of the area of the texture holding the image of this object,
+* which is the size of the whole texture, if it is not shared. The size of the
+* texture is taken from the texture_repository, since an evicted texture has
+* released its pixels, see texture_repository::size().
+* \return Size of the image.
+*/
+sf::Vector2u Textureable::tex_size() const {
+
+	if (sf::IntRect() != m_tex_area) {
+
+		return sf::Vector2u(m_tex_area.width, m_tex_area.height);
+
+	}
+
+	return texture_repository::size(m_texture);
+
+}
@@ -0,0 +1,308 @@
+// texture_atlas.cpp
+
+#include "texture_atlas.hpp"
+#include <algorithm>
+#include <limits>
+
+// Member functions
+
+//! Value constructor.
+/*!
+* Creates an empty atlas. Pages are only created once they are needed.
+* \param page_size Width and height of the pages. It is limited to the maximum
+* texture size of the graphics card once the first page is created.
+* \param padding Number of empty pixels between two images.
+* \param factory Function creating the pages, null to create plain textures.
+*/
+texture_atlas::texture_atlas(unsigned int page_size, unsigned int padding,
+							 page_factory factory) :
+	m_page_size(page_size), m_padding(padding), m_factory(factory),
+	m_pages() {
+}
+
+//! Insert image into the atlas.
+/*!
+* Packs the image onto the first page with enough space left. If there is no
+* such page, a new one is created.
+* \param image Image to insert.
+* \param page Shared pointer which will hold reference to the page.
+* \param rect Rectangle which the image occupies on the page.
+* \return True on success, false if the image is too big for a page.
+*/
+bool texture_atlas::insert(const sf::Image& image, texture_ptr* page,
+						   sf::IntRect* rect) {
+
+	if (!fits(image.getSize())) {
+
+		return false;
+
+	}
+
+	// Reserve the padding right and below the image.
+	auto width = static_cast<int>(image.getSize().x + m_padding);
+	auto height = static_cast<int>(image.getSize().y + m_padding);
+
+	std::size_t index{};
+	sf::Vector2i pos;
+
+	auto pg = m_pages.begin();
+	while (m_pages.end() != pg && !find(*pg, width, height, &index, &pos)) {
+
+		++ pg;
+
+	}
+
+	if (m_pages.end() == pg) {
+
+		if (!add_page()) {
+
+			return false;
+
+		}
+
+		pg = m_pages.end() - 1;
+
+		if (!find(*pg, width, height, &index, &pos)) {
+
+			return false;
+
+		}
+
+	}
+
+	place(*pg, index, pos, width, height);
+	pg->tex->update(image, pos.x, pos.y);
+
+	*page = pg->tex;
+	*rect = sf::IntRect(pos.x, pos.y, image.getSize().x, image.getSize().y);
+
+	return true;
+
+}
+
+//! Check whether an image is small enough for the atlas.
+/*!
+* Only images up to half the page size are accepted, bigger images would
+* leave too much unused space on the pages and gain nothing from sharing one.
+* \param size Size of the image.
+* \return True if the image can be inserted.
+*/
+bool texture_atlas::fits(const sf::Vector2u& size) const {
+
+	auto limit = m_page_size / 2;
+
+	return 0 < size.x && 0 < size.y &&
+		   size.x + m_padding <= limit && size.y + m_padding <= limit;
+
+}
+
+//! Number of pages.
+/*!
+* \return Number of pages currently used by the atlas.
+*/
+std::size_t texture_atlas::pages() const {
+
+	return m_pages.size();
+
+}
+
+//! Add a new, empty page.
+/*!
+* Creates a page whose pixels are all transparent and whose skyline is a
+* single segment at the top. The texture is created by the factory, if there
+* is one.
+* \return True on success.
+*/
+bool texture_atlas::add_page() {
+
+	m_page_size = std::min(m_page_size, sf::Texture::getMaximumSize());
+
+	page pg;
+
+	if (nullptr != m_factory) {
+
+		pg.tex = m_factory(m_page_size, m_pages.size());
+
+	} else {
+
+		std::vector<sf::Uint8> pixels(m_page_size * m_page_size * 4, 0);
+
+		pg.tex = texture_ptr(new sf::Texture);
+		if (pg.tex->create(m_page_size, m_page_size)) {
+
+			pg.tex->update(pixels.data());
+
+		} else {
+
+			pg.tex = nullptr;
+
+		}
+
+	}
+
+	if (nullptr == pg.tex) {
+
+		return false;
+
+	}
+
+	pg.skyline.push_back(skyline_node{0, 0, static_cast<int>(m_page_size)});
+	m_pages.push_back(pg);
+
+	return true;
+
+}
+
+//! Find the position for an image.
+/*!
+* Checks every segment of the skyline as left end of the image and takes the
+* one where the bottom edge of the image is the lowest. If there is a tie, the
+* narrower segment wins, so wide segments are kept for wide images.
+* \param pg Page to search.
+* \param width Width of the image, including padding.
+* \param height Height of the image, including padding.
+* \param index Index of the segment at which the image starts.
+* \param pos Position of the image on the page.
+* \return True if the image fits onto the page.
+*/
+bool texture_atlas::find(const page& pg, int width, int height,
+						 std::size_t* index, sf::Vector2i* pos) const {
+
+	auto best_bottom = std::numeric_limits<int>::max();
+	auto best_width = std::numeric_limits<int>::max();
+	auto found = false;
+
+	for (std::size_t i = 0; i < pg.skyline.size(); ++ i) {
+
+		int y{};
+		if (!fits(pg, i, width, height, &y)) {
+
+			continue;
+
+		}
+
+		auto bottom = y + height;
+		if (bottom < best_bottom ||
+			(bottom == best_bottom && pg.skyline[i].w < best_width)) {
+
+			best_bottom = bottom;
+			best_width = pg.skyline[i].w;
+			*index = i;
+			*pos = sf::Vector2i(pg.skyline[i].x, y);
+			found = true;
+
+		}
+
+	}
+
+	return found;
+
+}
+
+//! Check whether an image fits at a segment.
+/*!
+* The image has to rest on the highest segment it spans, starting with the
+* segment at index.
+* \param pg Page to check.
+* \param index Index of the segment at which the image starts.
+* \param width Width of the image, including padding.
+* \param height Height of the image, including padding.
+* \param y Top position of the image if it fits.
+* \return True if the image fits.
+*/
+bool texture_atlas::fits(const page& pg, std::size_t index, int width,
+						 int height, int* y) const {
+
+	auto size = static_cast<int>(m_page_size);
+
+	if (size < pg.skyline[index].x + width) {
+
+		return false;
+
+	}
+
+	auto top = 0;
+	auto width_left = width;
+
+	// Since the skyline covers the whole page width, the loop cannot run out
+	// of segments.
+	while (0 < width_left) {
+
+		top = std::max(top, pg.skyline[index].y);
+		if (size < top + height) {
+
+			return false;
+
+		}
+
+		width_left -= pg.skyline[index].w;
+		++ index;
+
+	}
+
+	*y = top;
+
+	return true;
+
+}
+
+//! Place an image onto the page.
+/*!
+* Adds the segment for the top edge of the image to the skyline. The segments
+* below the image are cut off or removed, and neighbouring segments of the same
+* height are merged.
+* \param pg Page to place the image on.
+* \param index Index of the segment at which the image starts.
+* \param pos Position of the image.
+* \param width Width of the image, including padding.
+* \param height Height of the image, including padding.
+*/
+void texture_atlas::place(page& pg, std::size_t index, const sf::Vector2i& pos,
+						  int width, int height) {
+
+	auto& skyline = pg.skyline;
+
+	skyline.insert(skyline.begin() + index,
+				   skyline_node{pos.x, pos.y + height, width});
+
+	// Shrink or remove the segments which are covered by the new one.
+	for (auto i = index + 1; i < skyline.size(); ) {
+
+		auto right = skyline[i - 1].x + skyline[i - 1].w;
+		if (skyline[i].x >= right) {
+
+			break;
+
+		}
+
+		auto shrink = right - skyline[i].x;
+		skyline[i].x += shrink;
+		skyline[i].w -= shrink;
+
+		if (0 < skyline[i].w) {
+
+			break;
+
+		}
+
+		skyline.erase(skyline.begin() + i);
+
+	}
+
+	// Merge segments of the same height.
+	for (std::size_t i = 0; i + 1 < skyline.size(); ) {
+
+		if (skyline[i].y == skyline[i + 1].y) {
+
+			skyline[i].w += skyline[i + 1].w;
+			skyline.erase(skyline.begin() + i + 1);
+
+		} else {
+
+			++ i;
+
+		}
+
+	}
+
+}
@@ -0,0 +1,323 @@
+// texture_bake.cpp
+
+#include "texture_bake.hpp"
+#include "mapped_file.hpp"
+#include "image_proc.hpp"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+// Member variables
+
+//! Directory of the baked images, baking is disabled if empty.
+std::string texture_bake::m_dir;
+
+// Member functions
+
+//! Set the directory of the baked images.
+/*!
+* The directory has to exist already. Setting an empty path disables baking.
+* \param path Directory in which the baked images are stored.
+*/
+void texture_bake::dir(const std::string& path) {
+
+	m_dir = path;
+
+}
+
+//! Get the directory of the baked images.
+/*!
+* \return Directory of the baked images, empty if baking is disabled.
+*/
+const std::string& texture_bake::dir() {
+
+	return m_dir;
+
+}
+
+//! Bake an image file.
+/*!
+* Decodes the file and bakes it, unless there already is a baked image which
+* is not stale. Meant to bake files in advance, e.g. by an install step.
+* \param filename Path of the image file to bake.
+* \param area Area of the image to bake, the whole image if empty.
+* \param size Size to scale the area down to, see image_proc::resample().
+* \return True if there is a baked image afterwards.
+*/
+bool texture_bake::bake(const std::string& filename, const sf::IntRect& area,
+						const sf::Vector2u& size) {
+
+	sf::Image image;
+	if (read(filename, area, size, &image)) {
+
+		return true;
+
+	}
+
+	if (!image.loadFromFile(filename)) {
+
+		return false;
+
+	}
+
+	if (sf::IntRect() != area) {
+
+		image = image_proc::crop(image, area);
+
+	}
+
+	return write(filename, area, size, image_proc::resample(image, size));
+
+}
+
+//! Read a baked image.
+/*!
+* Copies the pixels of the baked image into the image.
+* \param filename Path of the source image file.
+* \param area Area of the source image which has been baked.
+* \param size Target size the area has been baked with.
+* \param image Image which will hold the pixels.
+* \return True on success, false if there is no baked image or it is stale.
+*/
+bool texture_bake::read(const std::string& filename, const sf::IntRect& area,
+						const sf::Vector2u& size, sf::Image* image) {
+
+	if (m_dir.empty()) {
+
+		return false;
+
+	}
+
+	mapped_file mapping;
+	header head;
+	std::uint64_t key{};
+
+	if (!mapping.open(path(filename, area, size, &key))) {
+
+		return false;
+
+	}
+
+	head.key = key;
+	auto data = pixels(filename, mapping.data(), mapping.size(), &head);
+	if (nullptr == data) {
+
+		return false;
+
+	}
+
+	image->create(head.width, head.height, data);
+
+	return true;
+
+}
+
+//! Upload a baked image.
+/*!
+* Uploads the pixels of the baked image straight from the mapping of the cache
+* file into the texture, without any copy or decoding.
+*
+* NOTE: Has to be called from the render thread.
+* \param filename Path of the source image file.
+* \param area Area of the source image which has been baked.
+* \param size Target size the area has been baked with.
+* \param tex Texture to upload the pixels to.
+* \return True on success, false if there is no baked image or it is stale.
+*/
+bool texture_bake::upload(const std::string& filename, const sf::IntRect& area,
+						  const sf::Vector2u& size, sf::Texture* tex) {
+
+	if (m_dir.empty()) {
+
+		return false;
+
+	}
+
+	mapped_file mapping;
+	header head;
+	std::uint64_t key{};
+
+	if (!mapping.open(path(filename, area, size, &key))) {
+
+		return false;
+
+	}
+
+	head.key = key;
+	auto data = pixels(filename, mapping.data(), mapping.size(), &head);
+	if (nullptr == data || !tex->create(head.width, head.height)) {
+
+		return false;
+
+	}
+
+	tex->update(data);
+
+	return true;
+
+}
+
+//! Write a baked image.
+/*!
+* Bakes the image, which has to be the final image to upload, i.e. the area of
+* the source image already scaled down to the target size. The area and the
+* size are only used to identify the baked image. The cache file is written
+* under a temporary name first and renamed afterwards, so a crash never leaves
+* a half written file behind.
+* \param filename Path of the source image file.
+* \param area Area of the source image which has been loaded.
+* \param size Target size the area has been scaled down to.
+* \param image Image to bake.
+* \return True on success.
+*/
+bool texture_bake::write(const std::string& filename, const sf::IntRect& area,
+						 const sf::Vector2u& size, const sf::Image& image) {
+
+	auto img_size = image.getSize();
+	if (m_dir.empty() || 0 == img_size.x || 0 == img_size.y) {
+
+		return false;
+
+	}
+
+	header head;
+	std::memcpy(head.magic, "WOTB", 4);
+	head.version = 1;
+	head.width = img_size.x;
+	head.height = img_size.y;
+
+	if (!source_info(filename, &head)) {
+
+		return false;
+
+	}
+
+	auto target = path(filename, area, size, &head.key);
+	auto temp = target + ".tmp";
+
+	std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+	file.write(reinterpret_cast<const char*>(&head), sizeof(head));
+	file.write(reinterpret_cast<const char*>(image.getPixelsPtr()),
+			   static_cast<std::streamsize>(img_size.x) * img_size.y * 4);
+
+	file.close();
+	if (!file) {
+
+		std::remove(temp.c_str());
+		return false;
+
+	}
+
+	// Renaming onto an existing file fails on some systems.
+	std::remove(target.c_str());
+
+	return 0 == std::rename(temp.c_str(), target.c_str());
+
+}
+
+//! Get the path of a baked image.
+/*!
+* The name of the cache file is the hash of the source file path, the area and
+* the target size, so different areas and sizes of the same file are baked
+* separately.
+* \param filename Path of the source image file.
+* \param area Area of the source image.
+* \param size Target size of the area.
+* \param key Set to the hash, which is also stored inside the header.
+* \return Path of the cache file.
+*/
+std::string texture_bake::path(const std::string& filename,
+							   const sf::IntRect& area,
+							   const sf::Vector2u& size, std::uint64_t* key) {
+
+	auto id = filename + "|" + std::to_string(area.left) + "," +
+			  std::to_string(area.top) + "," + std::to_string(area.width) +
+			  "," + std::to_string(area.height) + "|" +
+			  std::to_string(size.x) + "x" + std::to_string(size.y);
+
+	// 64 bit FNV-1a.
+	std::uint64_t hash = 14695981039346656037ULL;
+	for (auto c : id) {
+
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ULL;
+
+	}
+
+	*key = hash;
+
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.wotb",
+				  static_cast<unsigned long long>(hash));
+
+	return m_dir + "/" + name;
+
+}
+
+//! Get size and modification time of the source file.
+/*!
+* \param filename Path of the source image file.
+* \param head Header in which the size and modification time are stored.
+* \return True on success, false if the file does not exist.
+*/
+bool texture_bake::source_info(const std::string& filename, header* head) {
+
+	struct stat info;
+	if (0 != stat(filename.c_str(), &info)) {
+
+		return false;
+
+	}
+
+	head->source_size = static_cast<std::uint64_t>(info.st_size);
+	head->source_mtime = static_cast<std::int64_t>(info.st_mtime);
+
+	return true;
+
+}
+
+//! Validate a baked image and get its pixels.
+/*!
+* Checks the header of the mapped cache file against the source file. The key
+* has to be set inside the header already, all other fields are filled in.
+* \param filename Path of the source image file.
+* \param data Content of the cache file.
+* \param size Size of the cache file.
+* \param head Header, holding the expected key.
+* \return Pointer to the pixels inside the cache file, null if the baked
+* image is broken or stale.
+*/
+const unsigned char* texture_bake::pixels(const std::string& filename,
+										  const void* data, std::size_t size,
+										  header* head) {
+
+	header source;
+	if (sizeof(header) > size || !source_info(filename, &source)) {
+
+		return nullptr;
+
+	}
+
+	auto key = head->key;
+	std::memcpy(head, data, sizeof(header));
+
+	if (0 != std::memcmp(head->magic, "WOTB", 4) || 1 != head->version ||
+		key != head->key || source.source_size != head->source_size ||
+		source.source_mtime != head->source_mtime) {
+
+		return nullptr;
+
+	}
+
+	auto payload = static_cast<std::uint64_t>(head->width) * head->height * 4;
+	if (size - sizeof(header) < payload || 0 == payload) {
+
+		return nullptr;
+
+	}
+
+	return static_cast<const unsigned char*>(data) + sizeof(header);
+
+}
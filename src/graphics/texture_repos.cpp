@@ -1,7 +1,16 @@
 // texture_repository.cpp
 
 #include "texture_repos.hpp"
+#include "texture_atlas.hpp"
+#include "texture_bake.hpp"
+#include "image_proc.hpp"
+#include "lz_codec.hpp"
+#include "worker_pool.hpp"
 #include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <cstdint>
 
 // ADD texture_repository HANDLING FUNCTIONS TO THE SPRITE CLASS:
 // REMEMBER - OVERLOAD THE COPY CONSTRUCTOR AND CALL inc_ref INSIDE OF IT
@@ -9,18 +18,105 @@
 
 // Member variables
 
-//! List holding all textures.
+//! Number of shards.
+const std::size_t texture_repository::shard_count;
+
+//! Number of buckets of the load latency histogram.
+const std::size_t texture_repository::latency_buckets;
+
+//! Shards holding the textures.
+/*!
+* At first, they should be empty. Each texture belongs to the shard chosen by
+* the hash of its key, see shard_index().
+*/
+texture_repository::repo_shard
+	texture_repository::m_shards[texture_repository::shard_count];
+
+//! Shard for the next texture without a key.
+std::atomic<std::size_t> texture_repository::m_next_shard(0);
+
+//! Counter which is increased on every use of a texture.
+/*!
+* Each texture stores the tick of its last use, which orders the textures of
+* all shards by their last use, see shrink().
+*/
+std::atomic<std::uint64_t> texture_repository::m_tick(0);
+
+//! Maximum number of bytes the textures may take up on the graphics card.
+/*!
+* Zero means there is no limit.
+*/
+std::atomic<std::size_t> texture_repository::m_budget(0);
+
+//! Number of bytes the resident textures take up on the graphics card.
+std::atomic<std::size_t> texture_repository::m_bytes(0);
+
+//! Highest number of bytes the resident textures have taken up so far.
+std::atomic<std::size_t> texture_repository::m_peak_bytes(0);
+
+//! Maximum number of bytes the compressed tier may take up in RAM.
+/*!
+* Zero means the tier is disabled.
+*/
+std::atomic<std::size_t> texture_repository::m_tier_budget(0);
+
+//! Number of bytes the compressed tier takes up in RAM.
+std::atomic<std::size_t> texture_repository::m_tier_bytes(0);
+
+//! Number of load calls served by the cache.
+std::atomic<std::size_t> texture_repository::m_hits(0);
+
+//! Number of load calls which had to decode and upload the image.
+std::atomic<std::size_t> texture_repository::m_misses(0);
+
+//! Number of textures evicted from the graphics card.
+std::atomic<std::size_t> texture_repository::m_evictions(0);
+
+//! Number of evicted textures which have been restored.
+std::atomic<std::size_t> texture_repository::m_reloads(0);
+
+//! Number of loads per latency bucket, see latency_bound().
+/*!
+* Zero initialized like every static variable.
+*/
+std::atomic<std::size_t>
+	texture_repository::m_latency[texture_repository::latency_buckets];
+
+//! List holding all textures waiting for their upload.
+/*!
+* Only used by the render thread, so it is not guarded.
+*/
+std::list<texture_repository::pending_load> texture_repository::m_pending;
+
+//! Guards the atlas and its cache.
+std::mutex texture_repository::m_atlas_mutex;
+
+//! Atlas holding the small images.
+/*!
+* Its pages are created by the repository, see create_page().
+*/
+texture_atlas texture_repository::m_atlas(1024, 1,
+										  &texture_repository::create_page);
+
+//! Cache of all images inside the atlas.
 /*!
-* At first, it should be an empty list.
+* Maps the key of a source to the page and the rectangle on it. Since the
+* atlas never gives space back, it is fine to hold the pages strongly.
 */
-std::list<texture_ptr> texture_repository::m_textures;
+std::map<std::string, std::pair<texture_ptr, sf::IntRect>>
+	texture_repository::m_atlas_cache;
 
-//! Internal counter of destructed texture holding objects.
+//! False once the repository has been destructed.
 /*!
-* Holds the number of objects destructed which had a reference to a texture
-* pointer.
+* Atomic, since textures may be released on any thread, see release().
 */
-std::size_t texture_repository::destruct_count = 0 ;
+std::atomic<bool> texture_repository::m_alive(true);
+
+//! Guard marking the end of the lifetime of the repository.
+/*!
+* ATTENTION: Has to stay the last member variable defined in this file.
+*/
+texture_repository::lifetime_guard texture_repository::m_guard;
 
 // Member functions
 
@@ -33,22 +129,35 @@ std::size_t texture_repository::destruct_count = 0 ;
 * \param tex_ptr Shared pointer which will hold reference to texture.
 * \param filename Path of the image file to load.
 * \param area Area of the image to load.
+* \param size Size to scale the area down to, zero to keep its size.
 * \return True on success.
 */
 bool texture_repository::load(texture_ptr* tex_ptr, const std::string& filename,
-                              const sf::IntRect& area) {
+                              const sf::IntRect& area,
+                              const sf::Vector2u& size) {
+
+	auto key = make_key("file:" + filename, area, size);
+
+	if (lookup(tex_ptr, key)) {
+
+		return true;
+
+	}
 
-	m_textures.emplace_back(new sf::Texture);
+	sf::Clock clock;
 
-	if (!m_textures.back()->loadFromFile(filename, area)) {
+	auto tex = create(key);
+
+	if (!load_file(tex.get(), filename, area, size)) {
 
         // Could not load file.
         return false;
 
 	}
 
-    // Reference the stored texture, increases use_count().
-    *tex_ptr = m_textures.back();
+	store(tex_ptr, tex, key, filename, area, size);
+
+	count_load(clock.getElapsedTime());
 
     /*std::cout << "Size of the texture: ";
     std::cout << m_textures.back()->getSize().x << ", ";
@@ -68,22 +177,50 @@ bool texture_repository::load(texture_ptr* tex_ptr, const std::string& filename,
 * \param data Data in memory from which to load.
 * \param size Size of the block of data.
 * \param area Area of the image to load.
+* \param tex_size Size to scale the area down to, zero to keep its size.
 * \return True on success.
 */
 bool texture_repository::load(texture_ptr* tex_ptr, const void* data,
-                              std::size_t size, const sf::IntRect& area) {
+                              std::size_t size, const sf::IntRect& area,
+                              const sf::Vector2u& tex_size) {
 
-	m_textures.emplace_back(new sf::Texture);
+	auto key = make_key("mem:" + hash_key(data, size), area, tex_size);
 
-	if (!m_textures.back()->loadFromMemory(data, size, area)) {
+	if (lookup(tex_ptr, key)) {
 
-        // Could not load file.
-        return false;
+		return true;
 
 	}
 
-    // Reference the stored texture, increases use_count().
-    *tex_ptr = m_textures.back();
+	sf::Clock clock;
+
+	auto tex = create(key);
+
+	if (sf::Vector2u() == tex_size) {
+
+		if (!tex->loadFromMemory(data, size, area)) {
+
+			// Could not load file.
+			return false;
+
+		}
+
+	} else {
+
+		sf::Image image;
+		if (!image.loadFromMemory(data, size) ||
+			!tex->loadFromImage(process(image, area, tex_size))) {
+
+			// Could not load file.
+			return false;
+
+		}
+
+	}
+
+	store(tex_ptr, tex, key);
+
+	count_load(clock.getElapsedTime());
 
     return true;
 
@@ -95,26 +232,65 @@ bool texture_repository::load(texture_ptr* tex_ptr, const void* data,
 * only a sub-rectangle of the image. If the whole image should be loaded, leave
 * this parameter by its default value. After the texture is successfully loaded,
 * a pointer is stored in the texture_ptr.
+*
+* NOTE: In order to look the stream up in the cache, its whole content is read
+* into memory first and then loaded like a file in memory. Only if the size of
+* the stream cannot be determined, it is decoded directly and not cached.
 * \param tex_pointer Shared pointer which will hold reference to texture.
 * \param stream Custom stream from which to load.
 * \param area Area of the image to load.
+* \param size Size to scale the area down to, zero to keep its size.
 * \return True on success.
 */
 bool texture_repository::load(texture_ptr* tex_ptr,
                                       sf::InputStream& stream,
-                                      const sf::IntRect& area) {
+                                      const sf::IntRect& area,
+                                      const sf::Vector2u& size) {
 
-	m_textures.emplace_back(new sf::Texture);
+	auto length = stream.getSize();
 
-	if (!m_textures.back()->loadFromStream(stream, area)) {
+	if (0 < length && 0 == stream.seek(0)) {
 
-        // Could not load file.
-        return false;
+		std::vector<char> buffer(static_cast<std::size_t>(length));
+		if (stream.read(buffer.data(), length) == length) {
+
+			return load(tex_ptr, buffer.data(), buffer.size(), area, size);
+
+		}
+
+		stream.seek(0);
 
 	}
 
-    // Reference the stored texture, increases use_count().
-    *tex_ptr = m_textures.back();
+	sf::Clock clock;
+	auto tex = create(std::string());
+
+	if (sf::Vector2u() == size) {
+
+		if (!tex->loadFromStream(stream, area)) {
+
+			// Could not load file.
+			return false;
+
+		}
+
+	} else {
+
+		sf::Image image;
+		if (!image.loadFromStream(stream) ||
+			!tex->loadFromImage(process(image, area, size))) {
+
+			// Could not load file.
+			return false;
+
+		}
+
+	}
+
+	// Nothing to look up later on, so do not add it to the cache.
+	store(tex_ptr, tex, std::string());
+
+	count_load(clock.getElapsedTime());
 
     return true;
 
@@ -129,60 +305,1726 @@ bool texture_repository::load(texture_ptr* tex_ptr,
 * \param tex_pointer Shared pointer which will hold reference to texture.
 * \param image Image from which to load.
 * \param area Area of the image to load.
+* \param size Size to scale the area down to, zero to keep its size.
 * \return True on success.
 */
 bool texture_repository::load(texture_ptr* tex_ptr,
                                       const sf::Image& image,
-                                      const sf::IntRect& area) {
+                                      const sf::IntRect& area,
+                                      const sf::Vector2u& size) {
+
+	auto img_size = image.getSize();
+	auto key = make_key("img:" + std::to_string(img_size.x) + "x" +
+						std::to_string(img_size.y) + ":" +
+						hash_key(image.getPixelsPtr(),
+								 img_size.x * img_size.y * 4), area, size);
+
+	if (lookup(tex_ptr, key)) {
+
+		return true;
 
-	m_textures.emplace_back(new sf::Texture);
+	}
+
+	sf::Clock clock;
 
-	if (!m_textures.back()->loadFromImage(image, area)) {
+	auto tex = create(key);
+	auto loaded = (sf::Vector2u() == size) ?
+				  tex->loadFromImage(image, area) :
+				  tex->loadFromImage(process(image, area, size));
+
+	if (!loaded) {
 
         // Could not load file.
         return false;
 
 	}
 
-    // Reference the stored texture, increases use_count().
-    *tex_ptr = m_textures.back();
+	store(tex_ptr, tex, key);
+
+	count_load(clock.getElapsedTime());
+
+    return true;
+
+}
+
+//! Load a texture from a memory mapped file.
+/*!
+* Maps the file into memory and hands the mapping directly to the decoder, so
+* the file is not read into a buffer first, see mapped_file. The mapping is
+* released once the texture is uploaded, unless it should be kept. A kept
+* mapping is used to restore the texture after eviction, which then does not
+* need to read the file again. If the file cannot be mapped, it is loaded like
+* any other file.
+*
+* NOTE: The texture shares the cache entry with load() of the same file and
+* area, whichever loads it first.
+* \param tex_ptr Shared pointer which will hold reference to texture.
+* \param filename Path of the image file to load.
+* \param area Area of the image to load.
+* \param size Size to scale the area down to, zero to keep its size.
+* \param keep_mapping True if the mapping should be kept for eviction.
+* \return True on success.
+*/
+bool texture_repository::load_mapped(texture_ptr* tex_ptr,
+									 const std::string& filename,
+									 const sf::IntRect& area,
+									 const sf::Vector2u& size,
+									 bool keep_mapping) {
+
+	auto key = make_key("file:" + filename, area, size);
+
+	if (lookup(tex_ptr, key)) {
+
+		return true;
+
+	}
+
+	sf::Clock clock;
+
+	auto mapping = std::make_shared<mapped_file>();
+	auto mapped = mapping->open(filename);
+
+	auto tex = create(key);
+
+	if (!load_file(tex.get(), filename, area, size,
+				   mapped ? mapping.get() : nullptr)) {
+
+        // Could not load file.
+        return false;
+
+	}
+
+	if (store(tex_ptr, tex, key, filename, area, size) && mapped &&
+		keep_mapping) {
+
+		auto shard = shard_of(tex);
+		std::lock_guard<std::mutex> lock(shard->mutex);
+		shard->entries[tex.get()]->mapping = mapping;
+
+	}
+
+	count_load(clock.getElapsedTime());
+
+    return true;
+
+}
+
+//! Load a texture from a file asynchronously.
+/*!
+* Decodes the file on the shared worker_pool and returns immediately. Until the
+* image is uploaded by upload_pending(), the texture holds a fully transparent
+* placeholder. The placeholder has the size of the scaled area, or is a single
+* pixel if the whole image is loaded. The texture itself is the same object
+* before and after the upload, so every holder of the pointer gets to see the
+* image.
+*
+* NOTE: Has to be called from the render thread, just like upload_pending().
+* \param tex_ptr Shared pointer which will hold reference to texture.
+* \param filename Path of the image file to load.
+* \param area Area of the image to load.
+* \param size Size to scale the area down to, zero to keep its size. The
+* image is scaled by the worker as well.
+* \return Future which becomes true once the texture has been uploaded, or
+* false if the file could not be loaded.
+*/
+std::shared_future<bool> texture_repository::load_async(texture_ptr* tex_ptr,
+								const std::string& filename,
+								const sf::IntRect& area,
+								const sf::Vector2u& size) {
+
+	auto key = make_key("file:" + filename, area, size);
+
+	if (lookup(tex_ptr, key)) {
+
+		// The texture might still be waiting for its upload.
+		for (auto& pending : m_pending) {
+
+			if (pending.tex == *tex_ptr) {
+
+				return pending.result;
+
+			}
+
+		}
+
+		std::promise<bool> loaded;
+		loaded.set_value(true);
+
+		return loaded.get_future().share();
+
+	}
+
+	// Create the placeholder.
+	unsigned int width = (0 < area.width) ? area.width : 1;
+	unsigned int height = (0 < area.height) ? area.height : 1;
+	auto holder_size = image_proc::target_size(sf::Vector2u(width, height),
+											   size);
+	std::vector<sf::Uint8> pixels(holder_size.x * holder_size.y * 4, 0);
+
+	auto tex = create(key);
+	tex->create(holder_size.x, holder_size.y);
+	tex->update(pixels.data());
+
+	if (!store(tex_ptr, tex, key, filename, area, size)) {
+
+		// Another thread has loaded the file meanwhile.
+		std::promise<bool> loaded;
+		loaded.set_value(true);
+
+		return loaded.get_future().share();
+
+	}
+
+	{
+
+		// The placeholder must not be evicted, it would be reloaded from the
+		// file on the render thread.
+		auto shard = shard_of(tex);
+		std::lock_guard<std::mutex> lock(shard->mutex);
+		shard->entries[tex.get()]->pinned = true;
+
+	}
+
+	m_pending.emplace_back();
+	auto& pending = m_pending.back();
+	pending.tex = tex;
+	pending.key = key;
+	pending.result = pending.done.get_future().share();
+	pending.image = worker_pool::shared().submit([filename, area, size]() {
+
+		return decode(filename, area, size);
+
+	});
+
+	return pending.result;
+
+}
+
+//! Upload decoded images of asynchronous loads.
+/*!
+* Uploads all images which have been decoded since the last call into their
+* textures, replacing the placeholders. Loads which are still being decoded are
+* left for the next call. If an image could not be decoded, the texture keeps
+* the placeholder and the texture is removed from the cache, so the next load
+* of the file tries again.
+*
+* NOTE: Has to be called from the render thread, preferably once per frame
+* before drawing.
+* \return Number of loads which are still pending.
+*/
+std::size_t texture_repository::upload_pending() {
+
+	for (auto it = m_pending.begin(); it != m_pending.end(); ) {
+
+		if (std::future_status::ready !=
+			it->image.wait_for(std::chrono::seconds(0))) {
+
+			++ it;
+			continue;
+
+		}
+
+		auto image = it->image.get();
+		auto uploaded = (nullptr != image) && it->tex->loadFromImage(*image);
+
+		auto shard = shard_of(it->tex);
+		std::unique_lock<std::mutex> lock(shard->mutex);
+
+		if (!uploaded) {
+
+			shard->cache.erase(it->key);
+
+		}
+
+		// Account for the real size of the texture, which can be evicted from
+		// now on. The pending load still holds a reference, so the texture is
+		// still inside the list.
+		auto entry = shard->entries.find(it->tex.get());
+		if (shard->entries.end() != entry) {
+
+			auto& tex_entry = *entry->second;
+			m_bytes -= tex_entry.bytes;
+			tex_entry.tex_size = tex_entry.tex->getSize();
+			tex_entry.bytes = tex_bytes(*tex_entry.tex);
+			count_bytes(tex_entry.bytes);
+			tex_entry.pinned = false;
+
+			if (!uploaded) {
+
+				// Keep the placeholder instead of the broken file.
+				tex_entry.file.clear();
+
+			}
+
+		}
+
+		lock.unlock();
+
+		if (uploaded) {
+
+			count_load(it->clock.getElapsedTime());
+
+		}
+
+		it->done.set_value(uploaded);
+		it = m_pending.erase(it);
+
+	}
+
+	shrink();
+
+	return m_pending.size();
+
+}
+
+//! Decode a file.
+/*!
+* Decodes the file the same way the other load functions do before they upload
+* the image: the area is cut out and scaled to the target size, and a baked
+* image is used if there is one, see texture_bake. The result can be uploaded
+* with load_decoded() or load_atlas().
+*
+* NOTE: Does not touch the repository or any texture, so it may be called from
+* any thread, e.g. by the worker_pool.
+* \param filename Path of the image file to decode.
+* \param area Area of the image to load.
+* \param size Size to scale the area down to, zero to keep its size.
+* \return Decoded image, null if the file could not be decoded.
+*/
+std::shared_ptr<sf::Image> texture_repository::decode(
+									const std::string& filename,
+									const sf::IntRect& area,
+									const sf::Vector2u& size) {
+
+	std::shared_ptr<sf::Image> image(new sf::Image);
+
+	// A baked image already holds only the scaled area.
+	if (texture_bake::read(filename, area, size, image.get())) {
+
+		return image;
+
+	}
+
+	// Decode straight from a mapping of the file, if possible.
+	mapped_file mapping;
+	auto decoded = mapping.open(filename) ?
+				   image->loadFromMemory(mapping.data(), mapping.size()) :
+				   image->loadFromFile(filename);
+
+	if (!decoded) {
+
+		return std::shared_ptr<sf::Image>();
+
+	}
+
+	image = std::make_shared<sf::Image>(process(*image, area, size));
+	texture_bake::write(filename, area, size, *image);
+
+	return image;
+
+}
+
+//! Load a texture from a decoded file.
+/*!
+* Uploads an image returned by decode() and registers it as if the file had
+* been loaded with load(), so later loads of the same file, area and size are
+* served by the cache.
+* \param tex_ptr Shared pointer which will hold reference to texture.
+* \param filename Path of the image file which has been decoded.
+* \param image Image returned by decode().
+* \param area Area of the image which has been decoded.
+* \param size Size the area has been scaled down to.
+* \return True on success.
+*/
+bool texture_repository::load_decoded(texture_ptr* tex_ptr,
+									  const std::string& filename,
+									  const sf::Image& image,
+									  const sf::IntRect& area,
+									  const sf::Vector2u& size) {
+
+	auto key = make_key("file:" + filename, area, size);
+
+	if (lookup(tex_ptr, key)) {
+
+		return true;
+
+	}
+
+	sf::Clock clock;
+
+	auto tex = create(key);
+
+	if (!tex->loadFromImage(image)) {
+
+        // Could not load file.
+        return false;
+
+	}
+
+	store(tex_ptr, tex, key, filename, area, size);
+
+	count_load(clock.getElapsedTime());
 
     return true;
 
 }
 
-//! Test whether to destruct a texture or not.
+//! Load a texture from a file into the atlas.
 /*!
-* This function is passed to std::list::remove_if() to be the condition under
-* which a texture is removed from the list. If the use count of a texture
-* pointer is one, only the std::list refers to it anymore, so it can be
-* destructed without any damage.
-* \param tex_ptr Texture pointer to the texture object.
-* \return True if std::shared_ptr::use_count() equals 1.
+* Loads the image and packs it into a page of the atlas, see texture_atlas.
+* The texture pointer references the page and the rectangle is set to the
+* area the image occupies on it. If the image is too big for the atlas, it is
+* loaded into an own texture instead and the rectangle covers all of it.
+*
+* ATTENTION: Images inside the atlas are never released. Only use this for
+* images needed for the whole runtime.
+* \param tex_ptr Shared pointer which will hold reference to texture.
+* \param rect Area of the texture which holds the image.
+* \param filename Path of the image file to load.
+* \param area Area of the image to load.
+* \return True on success.
 */
-bool texture_repository::remove_texture(const texture_ptr& tex_ptr) {
+bool texture_repository::load_atlas(texture_ptr* tex_ptr, sf::IntRect* rect,
+									const std::string& filename,
+									const sf::IntRect& area) {
 
-    return 1 == tex_ptr.use_count();
+	{
+
+		std::lock_guard<std::mutex> lock(m_atlas_mutex);
+		if (atlas_lookup(tex_ptr, rect, make_key("file:" + filename, area))) {
+
+			return true;
+
+		}
+
+	}
+
+	auto image = decode(filename, area, sf::Vector2u());
+	if (nullptr == image) {
+
+        // Could not load file.
+        ++ m_misses;
+		return false;
+
+	}
+
+	return load_atlas(tex_ptr, rect, filename, *image, area);
 
 }
 
-//! Removes all unused textures from the list if needed.
+//! Load a decoded file into the atlas.
 /*!
-* This function should be called in any object's destructor which uses a
-* texture. It basically handles a counter which is increased everytime an object
-* is release that had a reference to a texture pointer. Once this counter is
-* half the size of the internal texture list, a function is called to garbage
-* collect all unused textures.
+* Packs an image returned by decode() into a page of the atlas and registers
+* it as if the file had been loaded with load_atlas().
+*
+* ATTENTION: Images inside the atlas are never released. Only use this for
+* images needed for the whole runtime.
+* \param tex_ptr Shared pointer which will hold reference to texture.
+* \param rect Area of the texture which holds the image.
+* \param filename Path of the image file which has been decoded.
+* \param image Image returned by decode(), without scaling.
+* \param area Area of the image which has been decoded.
+* \return True on success.
 */
-void texture_repository::tidy() {
+bool texture_repository::load_atlas(texture_ptr* tex_ptr, sf::IntRect* rect,
+									const std::string& filename,
+									const sf::Image& image,
+									const sf::IntRect& area) {
+
+	auto key = make_key("file:" + filename, area);
+
+	std::unique_lock<std::mutex> lock(m_atlas_mutex);
+
+	if (atlas_lookup(tex_ptr, rect, key)) {
 
-    ++ destruct_count;
+		return true;
 
-	if (m_textures.size() < destruct_count) {
+	}
+
+	if (!m_atlas.fits(image.getSize())) {
+
+		lock.unlock();
+
+		// Too big, use an own texture.
+		if (!load_decoded(tex_ptr, filename, image, area)) {
+
+			return false;
+
+		}
+
+		*rect = sf::IntRect(0, 0, image.getSize().x, image.getSize().y);
+
+		return true;
 
-        m_textures.remove_if(remove_texture);
-        destruct_count = 0;
+	}
+
+	++ m_misses;
+
+	if (!m_atlas.insert(image, tex_ptr, rect)) {
+
+		return false;
 
 	}
 
+	m_atlas_cache[key] = std::make_pair(*tex_ptr, *rect);
+
+	return true;
+
+}
+
+//! Load a view of an area of a file.
+/*!
+* Loads the whole file into a texture, or takes the already loaded one, and
+* sets the rectangle to the area on it. So loading several areas of the same
+* file, e.g. the frames of a sprite sheet, uploads the image only once and all
+* views share the same texture. The area is clipped to the image.
+*
+* NOTE: The texture is the same as the one of load() without an area, which
+* means views are evicted and restored together with it.
+* \param tex_ptr Shared pointer which will hold reference to the texture of
+* the whole file.
+* \param rect Area of the texture which holds the view.
+* \param filename Path of the image file to load.
+* \param area Area of the image to view, the whole image if empty.
+* \return True on success.
+*/
+bool texture_repository::load_view(texture_ptr* tex_ptr, sf::IntRect* rect,
+								   const std::string& filename,
+								   const sf::IntRect& area) {
+
+	if (!load(tex_ptr, filename)) {
+
+		return false;
+
+	}
+
+	*rect = view_rect(size(*tex_ptr), area);
+
+	return true;
+
+}
+
+//! Load a view of an area of a file in memory.
+/*!
+* Loads the whole file in memory into a texture, or takes the already loaded
+* one, and sets the rectangle to the area on it, see load_view().
+* \param tex_ptr Shared pointer which will hold reference to the texture of
+* the whole file.
+* \param rect Area of the texture which holds the view.
+* \param data Data in memory from which to load.
+* \param size Size of the block of data.
+* \param area Area of the image to view, the whole image if empty.
+* \return True on success.
+*/
+bool texture_repository::load_view(texture_ptr* tex_ptr, sf::IntRect* rect,
+								   const void* data, std::size_t size,
+								   const sf::IntRect& area) {
+
+	if (!load(tex_ptr, data, size)) {
+
+		return false;
+
+	}
+
+	*rect = view_rect(texture_repository::size(*tex_ptr), area);
+
+	return true;
+
+}
+
+//! Load a view of an area of an image.
+/*!
+* Loads the whole image into a texture, or takes the already loaded one, and
+* sets the rectangle to the area on it, see load_view().
+* \param tex_ptr Shared pointer which will hold reference to the texture of
+* the whole image.
+* \param rect Area of the texture which holds the view.
+* \param image Image from which to load.
+* \param area Area of the image to view, the whole image if empty.
+* \return True on success.
+*/
+bool texture_repository::load_view(texture_ptr* tex_ptr, sf::IntRect* rect,
+								   const sf::Image& image,
+								   const sf::IntRect& area) {
+
+	if (!load(tex_ptr, image)) {
+
+		return false;
+
+	}
+
+	*rect = view_rect(size(*tex_ptr), area);
+
+	return true;
+
+}
+
+//! Number of cache hits.
+/*!
+* \return Number of load calls which were served with an already loaded
+* texture.
+*/
+std::size_t texture_repository::hits() {
+
+	return m_hits;
+
+}
+
+//! Number of cache misses.
+/*!
+* \return Number of load calls which had to decode and upload an image.
+*/
+std::size_t texture_repository::misses() {
+
+	return m_misses;
+
+}
+
+//! Get the statistics of the repository.
+/*!
+* Takes a snapshot of the counters and of every live texture. The shards are
+* locked one after the other, so the snapshot is consistent per shard only.
+* \return Statistics of the repository.
+*/
+texture_repository::statistics texture_repository::stats() {
+
+	statistics result;
+	result.live = 0;
+	result.bytes = m_bytes;
+	result.peak_bytes = m_peak_bytes;
+	result.budget = m_budget;
+	result.tier_bytes = m_tier_bytes;
+	result.hits = m_hits;
+	result.misses = m_misses;
+	result.evictions = m_evictions;
+	result.reloads = m_reloads;
+
+	for (std::size_t i = 0; i < latency_buckets; ++ i) {
+
+		result.latency[i] = m_latency[i];
+
+	}
+
+	for (auto& shard : m_shards) {
+
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		result.live += shard.textures.size();
+
+		for (auto& entry : shard.textures) {
+
+			source_stats source;
+			source.source = entry.file.empty() ? entry.key : entry.file;
+			source.refs = entry.ref.use_count();
+			source.bytes = entry.bytes;
+			source.resident = entry.resident;
+
+			result.sources.push_back(source);
+
+		}
+
+	}
+
+	return result;
+
+}
+
+//! Write the statistics of the repository as JSON.
+/*!
+* Writes the snapshot of stats() as a single JSON object. The latency
+* histogram is written as a list of buckets, each with its upper bound in
+* microseconds (null for the last, unbounded one) and its number of loads.
+* \param out Stream to write to.
+*/
+void texture_repository::write_stats(std::ostream& out) {
+
+	auto snapshot = stats();
+
+	out << "{\"live\":" << snapshot.live <<
+		   ",\"bytes\":" << snapshot.bytes <<
+		   ",\"peak_bytes\":" << snapshot.peak_bytes <<
+		   ",\"budget\":" << snapshot.budget <<
+		   ",\"tier_bytes\":" << snapshot.tier_bytes <<
+		   ",\"hits\":" << snapshot.hits <<
+		   ",\"misses\":" << snapshot.misses <<
+		   ",\"evictions\":" << snapshot.evictions <<
+		   ",\"reloads\":" << snapshot.reloads << ",\"latency\":[";
+
+	for (std::size_t i = 0; i < latency_buckets; ++ i) {
+
+		out << (0 < i ? "," : "") << "{\"max_us\":";
+
+		if (latency_buckets - 1 == i) {
+
+			out << "null";
+
+		} else {
+
+			out << latency_bound(i).asMicroseconds();
+
+		}
+
+		out << ",\"loads\":" << snapshot.latency[i] << "}";
+
+	}
+
+	out << "],\"sources\":[";
+
+	for (std::size_t i = 0; i < snapshot.sources.size(); ++ i) {
+
+		auto& source = snapshot.sources[i];
+
+		out << (0 < i ? "," : "") << "{\"source\":";
+		write_string(out, source.source);
+		out << ",\"refs\":" << source.refs <<
+			   ",\"bytes\":" << source.bytes <<
+			   ",\"resident\":" << (source.resident ? "true" : "false") << "}";
+
+	}
+
+	out << "]}";
+
+}
+
+//! Get the upper bound of a latency bucket.
+/*!
+* The first bucket holds the loads which took less than 128 microseconds, each
+* following bucket twice the time of the previous one. The last bucket holds
+* all slower loads.
+* \param bucket Index of the bucket.
+* \return Time the loads of the bucket took less than.
+*/
+sf::Time texture_repository::latency_bound(std::size_t bucket) {
+
+	return sf::microseconds(static_cast<sf::Int64>(128) << bucket);
+
+}
+
+//! Create cache key.
+/*!
+* Combines the identification of a source with the area which is loaded from
+* it and the size it is scaled to, so that different areas and sizes of the
+* same source are cached separately.
+* \param source Identification of the source, e.g. file path.
+* \param area Area of the image to load.
+* \param size Size the area is scaled down to.
+* \return Key for the texture cache.
+*/
+std::string texture_repository::make_key(const std::string& source,
+										 const sf::IntRect& area,
+										 const sf::Vector2u& size) {
+
+	return source + "|" + std::to_string(area.left) + "," +
+		   std::to_string(area.top) + "," + std::to_string(area.width) + "," +
+		   std::to_string(area.height) + "|" + std::to_string(size.x) + "x" +
+		   std::to_string(size.y);
+
+}
+
+//! Hash a block of memory.
+/*!
+* Calculates the 64 bit FNV-1a hash of the data and returns it, together with
+* the size of the data, as string. Hashing is way cheaper than decoding the
+* image, so it is fine to do it for every load from memory.
+* \param data Data in memory to hash.
+* \param size Size of the block of data.
+* \return Hash and size of the data as string.
+*/
+std::string texture_repository::hash_key(const void* data, std::size_t size) {
+
+	auto bytes = static_cast<const unsigned char*>(data);
+	std::uint64_t hash = 14695981039346656037ULL;
+
+	for (std::size_t i = 0; i < size; ++ i) {
+
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+
+	}
+
+	return std::to_string(hash) + ":" + std::to_string(size);
+
+}
+
+//! Look up texture inside the cache.
+/*!
+* If a still living texture is stored for the key, the texture pointer
+* references it, the use of the texture is recorded and the hit is counted.
+* Otherwise the miss is counted. An evicted texture is not restored, this is up
+* to the next touch() by the render thread. Until then, its size has to be
+* taken from size().
+* \param tex_ptr Shared pointer which will hold reference to texture.
+* \param key Key of the texture, see make_key().
+* \return True if the texture was found.
+*/
+bool texture_repository::lookup(texture_ptr* tex_ptr, const std::string& key) {
+
+	// Declared outside of the lock, so the reference is not dropped while the
+	// shard is locked, which would call release() and lock it again.
+	texture_ptr tex;
+
+	{
+
+		auto& shard = m_shards[shard_index(key)];
+		std::lock_guard<std::mutex> lock(shard.mutex);
+
+		auto it = shard.cache.find(key);
+		if (shard.cache.end() != it) {
+
+			tex = it->second.lock();
+			auto entry = shard.entries.find(tex.get());
+			if (nullptr != tex && shard.entries.end() != entry) {
+
+				use(shard, entry->second);
+
+			}
+
+		}
+
+	}
+
+	if (nullptr == tex) {
+
+		++ m_misses;
+		return false;
+
+	}
+
+	++ m_hits;
+	*tex_ptr = tex;
+
+	return true;
+
+}
+
+//! Look up image inside the atlas.
+/*!
+* \param tex_ptr Shared pointer which will hold reference to the page.
+* \param rect Area of the page which holds the image.
+* \param key Key of the image, see make_key().
+* \return True if the image is inside the atlas, the hit is counted then.
+*
+* NOTE: The atlas mutex has to be locked.
+*/
+bool texture_repository::atlas_lookup(texture_ptr* tex_ptr, sf::IntRect* rect,
+									  const std::string& key) {
+
+	auto it = m_atlas_cache.find(key);
+	if (m_atlas_cache.end() == it) {
+
+		return false;
+
+	}
+
+	++ m_hits;
+	*tex_ptr = it->second.first;
+	*rect = it->second.second;
+
+	return true;
+
+}
+
+//! Store newly loaded texture.
+/*!
+* Adds the texture to the front of the texture list of its shard, registers it
+* inside the cache and references it with the texture pointer. If another
+* thread has stored a living texture with the same key meanwhile, that one is
+* referenced instead and the new texture is dropped.
+* \param tex_ptr Shared pointer which will hold reference to texture.
+* \param tex Newly loaded texture, created by create() with the same key.
+* \param key Key of the texture, see make_key(). If empty, the texture is not
+* added to the cache.
+* \param file Path of the source file, if the texture has been loaded from a
+* file. Used to restore the texture after eviction.
+* \param area Area of the source file which has been loaded.
+* \param size Size the area has been scaled down to.
+* \param pinned True if the texture must never be evicted.
+* \return True if the texture has been stored, false if the texture of the
+* other thread is referenced.
+*/
+bool texture_repository::store(texture_ptr* tex_ptr, const texture_ptr& tex,
+							   const std::string& key, const std::string& file,
+							   const sf::IntRect& area,
+							   const sf::Vector2u& size, bool pinned) {
+
+	texture_ptr existing;
+
+	{
+
+		auto shard = shard_of(tex);
+		std::lock_guard<std::mutex> lock(shard->mutex);
+
+		if (!key.empty()) {
+
+			auto it = shard->cache.find(key);
+			if (shard->cache.end() != it) {
+
+				existing = it->second.lock();
+
+			}
+
+		}
+
+		if (nullptr == existing) {
+
+			texture_entry entry;
+			entry.tex = tex.get();
+			entry.ref = tex;
+			entry.key = key;
+			entry.file = file;
+			entry.area = area;
+			entry.size = size;
+			entry.tex_size = tex->getSize();
+			entry.bytes = tex_bytes(*tex);
+			entry.resident = true;
+			entry.pinned = pinned;
+			entry.smooth = false;
+			entry.repeated = false;
+			entry.used = ++ m_tick;
+
+			shard->textures.push_front(entry);
+			shard->entries[tex.get()] = shard->textures.begin();
+			count_bytes(entry.bytes);
+
+			if (!key.empty()) {
+
+				shard->cache[key] = tex;
+
+			}
+
+		}
+
+	}
+
+    // Reference the stored texture, increases use_count().
+    *tex_ptr = (nullptr != existing) ? existing : tex;
+
+	return nullptr == existing;
+
+}
+
+//! Record the use of a texture.
+/*!
+* Moves the texture to the front of the texture list of its shard and stamps
+* it with the next tick.
+*
+* NOTE: The shard has to be locked.
+* \param shard Shard holding the texture.
+* \param entry Position of the texture inside the texture list.
+*/
+void texture_repository::use(repo_shard& shard, entry_list::iterator entry) {
+
+	shard.textures.splice(shard.textures.begin(), shard.textures, entry);
+	entry->used = ++ m_tick;
+
+}
+
+//! Report the use of a texture.
+/*!
+* Moves the texture to the front of the texture list, so it is the last one to
+* be evicted. If it has been evicted, it is uploaded again. This function should
+* be called whenever a texture is drawn. Textures which have not been loaded by
+* the repository are ignored.
+*
+* NOTE: Has to be called from the render thread.
+* \param tex_ptr Texture which is used.
+*/
+void texture_repository::touch(const texture_ptr& tex_ptr) {
+
+	auto shard = shard_of(tex_ptr);
+	if (nullptr == shard) {
+
+		return;
+
+	}
+
+	{
+
+		std::lock_guard<std::mutex> lock(shard->mutex);
+
+		auto it = shard->entries.find(tex_ptr.get());
+		if (shard->entries.end() == it) {
+
+			return;
+
+		}
+
+		if (!it->second->resident && !reload(*it->second)) {
+
+			return;
+
+		}
+
+		use(*shard, it->second);
+
+	}
+
+	shrink();
+
+}
+
+//! Set the texture budget.
+/*!
+* Sets the maximum number of bytes the textures may take up on the graphics
+* card. If the textures already exceed the budget, the least recently used ones
+* are evicted immediately. Note that the most recently used texture is never
+* evicted, even if it exceeds the budget on its own.
+* \param bytes Maximum number of bytes, zero for no limit.
+*/
+void texture_repository::budget(std::size_t bytes) {
+
+	m_budget = bytes;
+	shrink();
+
+}
+
+//! Get the texture budget.
+/*!
+* \return Maximum number of bytes the textures may take up on the graphics
+* card, zero if there is no limit.
+*/
+std::size_t texture_repository::budget() {
+
+	return m_budget;
+
+}
+
+//! Get the used texture memory.
+/*!
+* \return Number of bytes the resident textures take up on the graphics card.
+*/
+std::size_t texture_repository::bytes() {
+
+	return m_bytes;
+
+}
+
+//! Set the budget of the compressed tier.
+/*!
+* Evicted textures are kept compressed in RAM, see lz_codec, as long as they fit
+* into this budget, so restoring them only takes a decompression instead of
+* reading and decoding their file. Once the budget is exceeded, the compressed
+* pixels of the least recently used textures are dropped, they are decoded from
+* their file again. Textures without a source file always keep their pixels
+* and do not count towards the budget.
+*
+* NOTE: Has to be called from the render thread.
+* \param bytes Maximum number of bytes, zero to disable the tier.
+*/
+void texture_repository::tier_budget(std::size_t bytes) {
+
+	m_tier_budget = bytes;
+	shrink();
+
+}
+
+//! Get the budget of the compressed tier.
+/*!
+* \return Maximum number of bytes the compressed tier may take up in RAM, zero
+* if it is disabled.
+*/
+std::size_t texture_repository::tier_budget() {
+
+	return m_tier_budget;
+
+}
+
+//! Get the memory used by the compressed tier.
+/*!
+* \return Number of bytes the compressed pixels of evicted textures take up in
+* RAM, without those of textures which have no source file.
+*/
+std::size_t texture_repository::tier_bytes() {
+
+	return m_tier_bytes;
+
+}
+
+//! Decode a file into a texture.
+/*!
+* Uploads the baked image of the file, if there is one which is not stale. If
+* not, the file is decoded, from the mapping if one is given, scaled and baked
+* for the next time, see texture_bake.
+* \param tex Texture to load into.
+* \param filename Path of the image file to load.
+* \param area Area of the image to load.
+* \param size Size to scale the area down to, zero to keep its size.
+* \param mapping Mapping of the file, null to read the file.
+* \return True on success.
+*/
+bool texture_repository::load_file(sf::Texture* tex, const std::string& filename,
+								   const sf::IntRect& area,
+								   const sf::Vector2u& size,
+								   const mapped_file* mapping) {
+
+	if (texture_bake::upload(filename, area, size, tex)) {
+
+		return true;
+
+	}
+
+	// Without baking and scaling, let the texture decode the file.
+	if (texture_bake::dir().empty() && sf::Vector2u() == size) {
+
+		return (nullptr != mapping) ?
+			   tex->loadFromMemory(mapping->data(), mapping->size(), area) :
+			   tex->loadFromFile(filename, area);
+
+	}
+
+	sf::Image image;
+	auto decoded = (nullptr != mapping) ?
+				   image.loadFromMemory(mapping->data(), mapping->size()) :
+				   image.loadFromFile(filename);
+
+	if (!decoded) {
+
+		return false;
+
+	}
+
+	image = process(image, area, size);
+	texture_bake::write(filename, area, size, image);
+
+	return tex->loadFromImage(image);
+
+}
+
+//! Prepare a decoded image for the upload.
+/*!
+* Cuts the area out of the image and scales it down to the target size, see
+* image_proc.
+* \param image Decoded image.
+* \param area Area of the image to load, the whole image if empty.
+* \param size Size to scale the area down to, zero to keep its size.
+* \return Image holding only the pixels which are uploaded.
+*/
+sf::Image texture_repository::process(const sf::Image& image,
+									  const sf::IntRect& area,
+									  const sf::Vector2u& size) {
+
+	if (sf::IntRect() == area) {
+
+		return image_proc::resample(image, size);
+
+	}
+
+	return image_proc::resample(image_proc::crop(image, area), size);
+
+}
+
+//! Clip the area of a view.
+/*!
+* Clips the area to the texture, the same way sf::Texture::loadFromImage()
+* clips the area it loads.
+* \param tex_size Size of the texture holding the whole image, see size().
+* \param area Area to view, the whole texture if empty.
+* \return Area of the texture to view.
+*/
+sf::IntRect texture_repository::view_rect(const sf::Vector2u& tex_size,
+										  const sf::IntRect& area) {
+
+	sf::IntRect whole(0, 0, tex_size.x, tex_size.y);
+	sf::IntRect rect;
+
+	if (sf::IntRect() == area || !whole.intersects(area, rect)) {
+
+		return whole;
+
+	}
+
+	return rect;
+
+}
+
+//! Calculate texture size in bytes.
+/*!
+* \param tex Texture to calculate the size of.
+* \return Number of bytes the texture takes up on the graphics card, assuming
+* four bytes per pixel.
+*/
+std::size_t texture_repository::tex_bytes(const sf::Texture& tex) {
+
+	return static_cast<std::size_t>(tex.getSize().x) * tex.getSize().y * 4;
+
+}
+
+//! Add to the bytes of the resident textures.
+/*!
+* Raises the peak as well, if it has been exceeded.
+* \param bytes Bytes a texture takes up on the graphics card.
+*/
+void texture_repository::count_bytes(std::size_t bytes) {
+
+	auto total = (m_bytes += bytes);
+	auto peak = m_peak_bytes.load();
+
+	while (peak < total && !m_peak_bytes.compare_exchange_weak(peak, total)) {
+	}
+
+}
+
+//! Count a load in the latency histogram.
+/*!
+* \param latency Time the load took.
+*/
+void texture_repository::count_load(const sf::Time& latency) {
+
+	std::size_t bucket = 0;
+
+	while (latency_buckets - 1 > bucket && latency >= latency_bound(bucket)) {
+
+		++ bucket;
+
+	}
+
+	++ m_latency[bucket];
+
+}
+
+//! Write a string as JSON.
+/*!
+* Quotes the string and escapes the characters JSON does not allow inside.
+* \param out Stream to write to.
+* \param text String to write.
+*/
+void texture_repository::write_string(std::ostream& out,
+									  const std::string& text) {
+
+	out << '"';
+
+	for (auto c : text) {
+
+		if ('"' == c || '\\' == c) {
+
+			out << '\\' << c;
+
+		} else if (0x20 > static_cast<unsigned char>(c)) {
+
+			out << "\\u" << std::hex << std::setw(4) << std::setfill('0') <<
+				   static_cast<int>(c) << std::dec << std::setfill(' ');
+
+		} else {
+
+			out << c;
+
+		}
+
+	}
+
+	out << '"';
+
+}
+
+//! Evict a texture from the graphics card.
+/*!
+* Releases the pixels of the texture, but keeps the texture object alive. If
+* the texture has not been loaded from a file, or the compressed tier is
+* enabled, its pixels are read back and kept compressed in RAM first, so it can
+* be restored later on.
+* \param entry Texture to evict.
+*/
+void texture_repository::evict(texture_entry& entry) {
+
+	if ((entry.file.empty() || 0 < m_tier_budget) && entry.packed.empty()) {
+
+		auto image = entry.tex->copyToImage();
+		entry.packed_size = image.getSize();
+		entry.packed = lz_codec::compress(image.getPixelsPtr(),
+										  static_cast<std::size_t>(
+										  entry.packed_size.x) *
+										  entry.packed_size.y * 4);
+		entry.packed.shrink_to_fit();
+
+		if (!entry.file.empty()) {
+
+			m_tier_bytes += entry.packed.size();
+
+		}
+
+	}
+
+	entry.smooth = entry.tex->isSmooth();
+	entry.repeated = entry.tex->isRepeated();
+
+	// Assigning an empty texture releases the pixels on the graphics card.
+	*entry.tex = sf::Texture();
+
+	entry.resident = false;
+	m_bytes -= entry.bytes;
+	++ m_evictions;
+
+}
+
+//! Restore an evicted texture.
+/*!
+* Uploads the pixels of an evicted texture again, either from the compressed
+* copy in RAM, from the kept mapping of its source file or from the source file
+* itself. The compressed copy is released afterwards.
+* \param entry Texture to restore.
+* \return True on success.
+*/
+bool texture_repository::reload(texture_entry& entry) {
+
+	auto loaded = false;
+
+	if (!entry.packed.empty()) {
+
+		auto size = entry.packed_size;
+		std::vector<std::uint8_t> pixels(static_cast<std::size_t>(size.x) *
+										 size.y * 4);
+
+		loaded = lz_codec::decompress(entry.packed.data(), entry.packed.size(),
+									  pixels.data(), pixels.size()) &&
+				 entry.tex->create(size.x, size.y);
+
+		if (loaded) {
+
+			entry.tex->update(pixels.data());
+
+		}
+
+	}
+
+	if (!loaded && !entry.file.empty()) {
+
+		loaded = load_file(entry.tex, entry.file, entry.area, entry.size,
+						   entry.mapping.get());
+
+	}
+
+	if (!loaded) {
+
+		std::cerr << "Could not restore evicted texture " << entry.file << "\n";
+		return false;
+
+	}
+
+	entry.tex->setSmooth(entry.smooth);
+	entry.tex->setRepeated(entry.repeated);
+	unpack(entry);
+	entry.resident = true;
+	entry.tex_size = entry.tex->getSize();
+	entry.bytes = tex_bytes(*entry.tex);
+	count_bytes(entry.bytes);
+	++ m_reloads;
+
+	return true;
+
+}
+
+//! Drop the compressed pixels of a texture.
+/*!
+* \param entry Texture whose compressed pixels are released.
+*/
+void texture_repository::unpack(texture_entry& entry) {
+
+	if (!entry.file.empty()) {
+
+		m_tier_bytes -= entry.packed.size();
+
+	}
+
+	std::vector<std::uint8_t>().swap(entry.packed);
+
+}
+
+//! Evict textures until the budgets are met.
+/*!
+* Evicts the least recently used textures until the resident textures fit into
+* the budget. The most recently used texture and pinned textures are never
+* evicted. Afterwards, the compressed pixels of the least recently used evicted
+* textures are dropped until the compressed tier fits into its budget.
+*
+* NOTE: Locks all shards, in the order of their index, so it is only called if
+* a budget is exceeded. Has to be called from the render thread.
+*/
+void texture_repository::shrink() {
+
+	if ((0 == m_budget || m_bytes <= m_budget) &&
+		m_tier_bytes <= m_tier_budget) {
+
+		return;
+
+	}
+
+	std::vector<std::unique_lock<std::mutex>> locks;
+	locks.reserve(shard_count);
+
+	for (auto& shard : m_shards) {
+
+		locks.emplace_back(shard.mutex);
+
+	}
+
+	auto last_used = m_tick.load();
+	auto next = tails();
+
+	while (0 != m_budget && m_budget < m_bytes) {
+
+		auto shard = oldest(&next, [last_used](const texture_entry& entry) {
+
+			return entry.resident && !entry.pinned && last_used != entry.used;
+
+		});
+
+		if (shard_count == shard) {
+
+			break;
+
+		}
+
+		evict(*next[shard]);
+		++ next[shard];
+
+	}
+
+	// Textures without a file do not count towards the tier, they have to
+	// keep their pixels.
+	next = tails();
+
+	while (m_tier_budget < m_tier_bytes) {
+
+		auto shard = oldest(&next, [](const texture_entry& entry) {
+
+			return !entry.file.empty() && !entry.packed.empty();
+
+		});
+
+		if (shard_count == shard) {
+
+			break;
+
+		}
+
+		unpack(*next[shard]);
+		++ next[shard];
+
+	}
+
+}
+
+//! Get the back of each shard.
+/*!
+* NOTE: All shards have to be locked.
+* \return Position of the least recently used texture of each shard.
+*/
+std::vector<texture_repository::entry_list::reverse_iterator>
+	texture_repository::tails() {
+
+	std::vector<entry_list::reverse_iterator> next;
+	next.reserve(shard_count);
+
+	for (auto& shard : m_shards) {
+
+		next.push_back(shard.textures.rbegin());
+
+	}
+
+	return next;
+
+}
+
+//! Find the least recently used texture of all shards.
+/*!
+* Moves the position of each shard towards its front until it points to a
+* candidate, and picks the shard whose candidate has been used the longest
+* time ago. Since each shard is ordered by the last use, this is the least
+* recently used candidate overall.
+*
+* NOTE: All shards have to be locked.
+* \param next Position inside each shard, see tails().
+* \param candidate Returns true for the textures which may be picked.
+* \return Index of the shard, or the number of shards if there is no
+* candidate left.
+*/
+std::size_t texture_repository::oldest(
+				std::vector<entry_list::reverse_iterator>* next,
+				const std::function<bool(const texture_entry&)>& candidate) {
+
+	auto result = shard_count;
+
+	for (std::size_t i = 0; i < shard_count; ++ i) {
+
+		auto& it = (*next)[i];
+		while (m_shards[i].textures.rend() != it && !candidate(*it)) {
+
+			++ it;
+
+		}
+
+		if (m_shards[i].textures.rend() != it &&
+			(shard_count == result || it->used < (*next)[result]->used)) {
+
+			result = i;
+
+		}
+
+	}
+
+	return result;
+
+}
+
+//! Number of live textures.
+/*!
+* \return Number of textures currently held by the repository.
+*/
+std::size_t texture_repository::live() {
+
+	std::size_t count = 0;
+
+	for (auto& shard : m_shards) {
+
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		count += shard.textures.size();
+
+	}
+
+	return count;
+
+}
+
+//! Get all live textures.
+/*!
+* Returns the textures currently held by the repository, shard by shard, the
+* most recently used one of each shard first. Meant for statistics and
+* debugging, the returned pointers keep the textures alive as long as they
+* exist.
+* \return All live textures.
+*/
+std::vector<texture_ptr> texture_repository::textures() {
+
+	std::vector<texture_ptr> result;
+
+	for (auto& shard : m_shards) {
+
+		std::lock_guard<std::mutex> lock(shard.mutex);
+
+		for (auto& entry : shard.textures) {
+
+			auto tex = entry.ref.lock();
+			if (nullptr != tex) {
+
+				result.push_back(tex);
+
+			}
+
+		}
+
+	}
+
+	return result;
+
+}
+
+//! Find the shared pointer of a texture.
+/*!
+* Looks the texture up by its address, in constant time per shard. Meant for
+* code which only got a reference to the texture, so it can share it instead
+* of copying it.
+* \param tex Texture to look up.
+* \return Shared pointer to the texture, or null if the texture is not held by
+* the repository.
+*/
+texture_ptr texture_repository::find(const sf::Texture* tex) {
+
+	texture_ptr result;
+
+	for (auto& shard : m_shards) {
+
+		std::lock_guard<std::mutex> lock(shard.mutex);
+
+		auto it = shard.entries.find(tex);
+		if (shard.entries.end() != it) {
+
+			result = it->second->ref.lock();
+			break;
+
+		}
+
+	}
+
+	return result;
+
+}
+
+//! Get the size of a texture.
+/*!
+* An evicted texture keeps its size, even though its pixels are released, so
+* objects using it are sized as if it was resident. Textures which have not
+* been loaded by the repository report their own size.
+* \param tex Texture to get the size of.
+* \return Size of the texture.
+*/
+sf::Vector2u texture_repository::size(const texture_ptr& tex) {
+
+	auto shard = shard_of(tex);
+	if (nullptr != shard) {
+
+		std::lock_guard<std::mutex> lock(shard->mutex);
+
+		auto it = shard->entries.find(tex.get());
+		if (shard->entries.end() != it) {
+
+			return it->second->tex_size;
+
+		}
+
+	}
+
+	return tex->getSize();
+
+}
+
+//! Choose the shard of a texture.
+/*!
+* \param key Key of the texture, see make_key().
+* \return Index of the shard for the key. Textures without a key are spread
+* over the shards in turn.
+*/
+std::size_t texture_repository::shard_index(const std::string& key) {
+
+	if (key.empty()) {
+
+		return m_next_shard++ % shard_count;
+
+	}
+
+	return std::hash<std::string>()(key) % shard_count;
+
+}
+
+//! Get the shard holding a texture.
+/*!
+* \param tex Texture created by create().
+* \return Shard of the texture, or null if it has not been created by the
+* repository.
+*/
+texture_repository::repo_shard* texture_repository::shard_of(
+												const texture_ptr& tex) {
+
+	auto deleter = std::get_deleter<releaser>(tex);
+	if (nullptr == deleter) {
+
+		return nullptr;
+
+	}
+
+	return &m_shards[deleter->shard];
+
+}
+
+//! Create a texture owned by the repository.
+/*!
+* Creates an empty texture whose shared pointer calls release() once the last
+* reference to it is gone.
+* \param key Key of the texture, which chooses its shard.
+* \return Shared pointer to the new texture.
+*/
+texture_ptr texture_repository::create(const std::string& key) {
+
+	return texture_ptr(new sf::Texture, releaser{shard_index(key)});
+
+}
+
+//! Create a page of the atlas.
+/*!
+* Creates a fully transparent texture and stores it like a loaded one, so its
+* memory is counted, see texture_atlas. Its key is "atlas:" followed by the
+* index of the page, which names it in the statistics. The page is pinned,
+* since images are copied onto it by load_atlas() on any thread.
+* \param size Width and height of the page.
+* \param index Index of the page inside the atlas.
+* \return Shared pointer to the page, null if it could not be created.
+*/
+texture_ptr texture_repository::create_page(unsigned int size,
+											std::size_t index) {
+
+	auto key = "atlas:" + std::to_string(index);
+	auto tex = create(key);
+	std::vector<sf::Uint8> pixels(static_cast<std::size_t>(size) * size * 4, 0);
+
+	if (!tex->create(size, size)) {
+
+		return texture_ptr();
+
+	}
+
+	tex->update(pixels.data());
+
+	texture_ptr page;
+	store(&page, tex, key, std::string(), sf::IntRect(), sf::Vector2u(), true);
+
+	return page;
+
+}
+
+//! Release a texture.
+/*!
+* Called by the deleter of all textures created by create(). Removes the
+* texture from the texture list and the cache of its shard, which takes
+* constant time, and deletes it. So a texture is released at the very moment
+* its last user lets go of it, on whatever thread that is.
+* \param tex Texture to release.
+* \param shard Index of the shard holding the texture.
+*/
+void texture_repository::release(sf::Texture* tex, std::size_t shard) {
+
+	// Once the repository itself is destructed at the end of the program,
+	// there is nothing left to remove the texture from.
+	if (m_alive) {
+
+		auto& owner = m_shards[shard];
+		std::lock_guard<std::mutex> lock(owner.mutex);
+
+		auto it = owner.entries.find(tex);
+		if (owner.entries.end() != it) {
+
+			auto entry = it->second;
+			if (entry->resident) {
+
+				m_bytes -= entry->bytes;
+
+			}
+
+			unpack(*entry);
+
+			// Another thread might already have loaded the source again.
+			auto cached = owner.cache.find(entry->key);
+			if (owner.cache.end() != cached && cached->second.expired()) {
+
+				owner.cache.erase(cached);
+
+			}
+
+			owner.entries.erase(it);
+			owner.textures.erase(entry);
+
+		}
+
+	}
+
+	delete tex;
+
+}
+
+//! Release a texture.
+/*!
+* \param tex Texture to release.
+*/
+void texture_repository::releaser::operator()(sf::Texture* tex) const {
+
+	release(tex, shard);
+
+}
+
+//! Mark the repository as destructed.
+/*!
+* The guard is defined after all containers of the repository, so it is
+* destructed before them.
+*/
+texture_repository::lifetime_guard::~lifetime_guard() {
+
+	m_alive = false;
+
 }
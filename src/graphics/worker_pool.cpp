@@ -0,0 +1,132 @@
+// worker_pool.cpp
+
+#include "worker_pool.hpp"
+
+// Member functions
+
+//! Value constructor.
+/*!
+* Starts the given amount of threads. If no amount is given, one thread less
+* than the hardware can run concurrently is started (at least one), so the
+* render thread still gets a core on its own.
+* \param threads Number of threads of the pool.
+*/
+worker_pool::worker_pool(std::size_t threads) : m_threads(), m_tasks(),
+	m_mutex(), m_cond(), m_stop(false) {
+
+	if (0 == threads) {
+
+		auto cores = std::thread::hardware_concurrency();
+		threads = (1 < cores) ? cores - 1 : 1;
+
+	}
+
+	for (std::size_t i = 0; i < threads; ++ i) {
+
+		m_threads.emplace_back(&worker_pool::work, this);
+
+	}
+
+}
+
+//! Default destructor.
+/*!
+* Stops the pool and waits for the threads to work off all tasks, including
+* those which have not been picked up yet, so every future returned by submit()
+* gets its result.
+*/
+worker_pool::~worker_pool() {
+
+	{
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+
+	}
+
+	m_cond.notify_all();
+
+	for (auto& thread : m_threads) {
+
+		thread.join();
+
+	}
+
+}
+
+//! Push a task into the pool.
+/*!
+* The task is run by the next thread which becomes idle.
+* \param task Task to run.
+*/
+void worker_pool::push(std::function<void()> task) {
+
+	{
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.push(std::move(task));
+
+	}
+
+	m_cond.notify_one();
+
+}
+
+//! Number of threads.
+/*!
+* \return Number of threads of the pool.
+*/
+std::size_t worker_pool::size() const {
+
+	return m_threads.size();
+
+}
+
+//! Get the shared pool.
+/*!
+* Returns the pool which is shared by the whole program. It is created with
+* the first call of this function.
+* \return Shared worker pool.
+*/
+worker_pool& worker_pool::shared() {
+
+	static worker_pool pool;
+
+	return pool;
+
+}
+
+//! Thread loop.
+/*!
+* Waits for tasks and runs them until the pool is stopped and the queue is
+* empty.
+*/
+void worker_pool::work() {
+
+	while (true) {
+
+		std::function<void()> task;
+
+		{
+
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cond.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+
+			// The queue is only empty here if the pool stops, queued tasks
+			// are still run so their futures do not break.
+			if (m_tasks.empty()) {
+
+				return;
+
+			}
+
+			task = std::move(m_tasks.front());
+			m_tasks.pop();
+
+		}
+
+		task();
+
+	}
+
+}
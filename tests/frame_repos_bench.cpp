@@ -0,0 +1,106 @@
+// frame_repos_bench.cpp
+
+#include <benchmark/benchmark.h>
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include "frame_repos.hpp"
+
+//! Frames of a sheet with 100 frames per row.
+/*!
+* \param count Number of frames.
+* \return Frames, row by row.
+*/
+static std::vector<frame> make_sheet(std::size_t count) {
+
+	std::vector<frame> frms;
+	frms.reserve(count);
+
+	for (std::size_t i = 0; i < count; ++ i) {
+
+		frms.push_back(frame(static_cast<int>(i % 100) * 64,
+							 static_cast<int>(i / 100) * 96, 64, 96));
+
+	}
+
+	return frms;
+
+}
+
+//! Texture rectangle cutting off a border of each frame.
+static const sf::IntRect rect(4, 8, 56, 80);
+
+//! Insert the frames one by one, like animations did before the bulk insert.
+static void insert_each(benchmark::State& state) {
+
+	auto frms = make_sheet(static_cast<std::size_t>(state.range(0)));
+
+	for (auto _ : state) {
+
+		frames_handle handle = NO_FRM;
+		frame_repository::create(&handle);
+
+		for (auto& frm : frms) {
+
+			frame_repository::insert(&handle, frm, rect);
+
+		}
+
+		frame_repository::release(&handle);
+
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+
+}
+
+//! Insert the frames one by one at the front.
+/*!
+* Each insert moves all frames inserted before, which is what inserting a
+* frame or frame group at an index did before the bulk insert. The frames are
+* inserted in reverse, so they end up in the same order as with the bulk
+* insert.
+*/
+static void insert_front(benchmark::State& state) {
+
+	auto frms = make_sheet(static_cast<std::size_t>(state.range(0)));
+
+	for (auto _ : state) {
+
+		frames_handle handle = NO_FRM;
+		frame_repository::create(&handle);
+
+		for (auto it = frms.rbegin(); it != frms.rend(); ++ it) {
+
+			frame_repository::insert(&handle, *it, 0, rect);
+
+		}
+
+		frame_repository::release(&handle);
+
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+
+}
+
+//! Insert all frames at once.
+static void insert_bulk(benchmark::State& state) {
+
+	auto frms = make_sheet(static_cast<std::size_t>(state.range(0)));
+
+	for (auto _ : state) {
+
+		frames_handle handle = NO_FRM;
+		frame_repository::create(&handle);
+		frame_repository::insert(&handle, frms.data(), frms.size(), 0, rect);
+		frame_repository::release(&handle);
+
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+
+}
+
+BENCHMARK(insert_each)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(insert_front)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(insert_bulk)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,331 @@
+// frame_repos_test.cpp
+
+#include <catch2/catch.hpp>
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include "animation.hpp"
+#include "frame_repos.hpp"
+#include "frame_table.hpp"
+
+//! Trimmed frame at (100, 50) on the sheet, placed at (10, 5) inside a
+//! logical frame of 64 x 64.
+static const frame trimmed(100, 50, 20, 30, 10, 5, 64, 64);
+
+//! Animation which exposes its vertices.
+class anim_probe : public animation {
+
+public :
+
+	const sf::Vertex* vertices() const {
+
+		return m_vertices;
+
+	}
+
+};
+
+//! Access to the generation stamps of the frame_repository.
+class frame_repository_probe {
+
+public :
+
+	static std::size_t outdated(frames_handle handle) {
+
+		return frame_repository::outdated(handle);
+
+	}
+
+	static void next_gen(std::uint32_t* gen,
+						 pool_vector<std::uint32_t>* stamps) {
+
+		frame_repository::next_gen(gen, stamps);
+
+	}
+
+};
+
+TEST_CASE("intersect clips trimmed frames in logical coordinates",
+		  "[frame_repository]") {
+
+	// The rectangle cuts off 6 pixels of the frame at the left, 3 at the
+	// bottom and starts 16 pixels into the logical frame.
+	CHECK(frame(106, 50, 14, 27, 0, 5, 32, 32) ==
+		  frame_repository::intersect(trimmed, sf::IntRect(16, 0, 32, 32)));
+
+	// Rectangles with a negative size cover the same part.
+	CHECK(frame(106, 50, 14, 27, 0, 5, 32, 32) ==
+		  frame_repository::intersect(trimmed, sf::IntRect(48, 32, -32, -32)));
+
+	// Only the transparent border is inside the rectangle.
+	CHECK(frame(100, 50, 0, 0) ==
+		  frame_repository::intersect(trimmed, sf::IntRect(40, 40, 10, 10)));
+
+}
+
+TEST_CASE("intersect keeps the position of plain frames",
+		  "[frame_repository]") {
+
+	// Like before frames could be trimmed, only the size is clipped.
+	CHECK(frame(0, 0, 56, 80) ==
+		  frame_repository::intersect(frame(0, 0, 64, 96),
+									  sf::IntRect(4, 8, 56, 80)));
+	CHECK(frame(128, 96, 32, 48) ==
+		  frame_repository::intersect(frame(128, 96, 64, 96),
+									  sf::IntRect(32, 48, 64, 64)));
+	CHECK(frame(128, 96, 0, 0) ==
+		  frame_repository::intersect(frame(128, 96, 64, 96),
+									  sf::IntRect(64, 0, 10, 10)));
+
+}
+
+TEST_CASE("bulk insert clips like intersect", "[frame_repository]") {
+
+	// More than four frames, so the vectorized path and the rest are used.
+	std::vector<frame> frms;
+
+	for (int i = 0; i < 11; ++ i) {
+
+		frms.push_back(frame(i * 64, 0, 20 + i, 30 - i, i * 3, 5 + i, 64, 64));
+		frms.push_back(frame(i * 64, 96, 64, 96));
+
+	}
+
+	frms.push_back(frame(0, 192, -20, 30, 30, 5, 64, 64));
+
+	const sf::IntRect rects[] = {sf::IntRect(16, 0, 32, 32),
+								 sf::IntRect(-8, 10, 40, 100),
+								 sf::IntRect(70, 0, -40, 20),
+								 sf::IntRect(60, 60, 10, 10)};
+
+	for (auto& rect : rects) {
+
+		frames_handle handle = NO_FRM;
+		frame_repository::create(&handle);
+		frame_repository::insert(&handle, frms.data(), frms.size(), 0, rect);
+
+		for (std::size_t i = 0; i < frms.size(); ++ i) {
+
+			CHECK(frame_repository::intersect(frms[i], rect) ==
+				  frame_repository::clipped(handle, i));
+
+		}
+
+		frame_repository::release(&handle);
+
+	}
+
+}
+
+TEST_CASE("frame_table clips like intersect", "[frame_repository]") {
+
+	typedef frame_table<0, 0, 256, 96, 64, 96, 4, 8, 56, 80> table;
+	auto handle = table::handle();
+
+	for (std::size_t i = 0; i < table::count; ++ i) {
+
+		auto frm = frame_repository::original(handle, i);
+
+		CHECK(frame_repository::intersect(frm, table::tex_rect()) ==
+			  frame_repository::clipped(handle, i));
+
+	}
+
+}
+
+TEST_CASE("animation bounds follow the texture rectangle",
+		  "[frame_repository]") {
+
+	animation anim;
+	anim.insert(trimmed);
+
+	CHECK(64.f == anim.loc_bound().width);
+
+	anim.setTexRect(sf::IntRect(16, 0, 32, 32));
+
+	CHECK(32.f == anim.loc_bound().width);
+	CHECK(32.f == anim.loc_bound().height);
+
+}
+
+TEST_CASE("setTexRect draws trimmed frames at their place",
+		  "[frame_repository]") {
+
+	anim_probe anim;
+	anim.insert(trimmed);
+	anim.render();
+
+	// Frame (106, 50, 14, 27) placed at (0, 5) inside a logical 32 x 32.
+	anim.setTexRect(sf::IntRect(16, 0, 32, 32));
+
+	auto vertices = anim.vertices();
+	CHECK(sf::Vector2f(0.f, 5.f) == vertices[0].position);
+	CHECK(sf::Vector2f(14.f, 32.f) == vertices[2].position);
+	CHECK(sf::Vector2f(106.f, 50.f) == vertices[0].texCoords);
+	CHECK(sf::Vector2f(120.f, 77.f) == vertices[2].texCoords);
+
+	// Setting the rectangle on every frame keeps the positions in step.
+	anim.setTexRect(sf::IntRect(0, 0, 64, 64));
+
+	CHECK(sf::Vector2f(10.f, 5.f) == vertices[0].position);
+	CHECK(sf::Vector2f(30.f, 35.f) == vertices[2].position);
+	CHECK(sf::Vector2f(100.f, 50.f) == vertices[0].texCoords);
+	CHECK(sf::Vector2f(120.f, 80.f) == vertices[2].texCoords);
+
+}
+
+TEST_CASE("identical frames are shared until one is edited",
+		  "[frame_repository]") {
+
+	const frame frm(7, 7, 13, 13);
+	const frame other(0, 0, 32, 32);
+	auto live = frame_repository::live();
+
+	frames_handle first = NO_FRM;
+	frames_handle second = NO_FRM;
+	frame_repository::create(&first);
+	frame_repository::create(&second);
+	frame_repository::insert(&first, frm);
+	frame_repository::insert(&second, frm);
+
+	frame_repository::intern(&first);
+	frame_repository::intern(&second);
+
+	CHECK(first == second);
+	CHECK(frame_repository::shared(first));
+	CHECK(live + 1 == frame_repository::live());
+
+	// The edit copies the frames, the other handle keeps the old ones.
+	frame_repository::replace(&second, other, 0);
+
+	CHECK(first != second);
+	CHECK_FALSE(frame_repository::shared(first));
+	CHECK_FALSE(frame_repository::shared(second));
+	CHECK(frm == frame_repository::original(first, 0));
+	CHECK(other == frame_repository::original(second, 0));
+	CHECK(live + 2 == frame_repository::live());
+
+	// Frames which differ are not merged.
+	frame_repository::intern(&second);
+	CHECK(first != second);
+
+	// Neither are frames which only differ in their durations.
+	frames_handle third = NO_FRM;
+	frame_repository::create(&third);
+	frame_repository::insert(&third, frm);
+	auto time = sf::milliseconds(50);
+	frame_repository::set_durations(&third, &time, 1, 0);
+	frame_repository::intern(&third);
+	CHECK(first != third);
+
+	frame_repository::release(&first);
+	frame_repository::release(&second);
+	frame_repository::release(&third);
+
+	CHECK(live == frame_repository::live());
+
+}
+
+TEST_CASE("a texture rectangle change clips only the accessed frames",
+		  "[frame_repository]") {
+
+	const std::vector<frame> frms = {trimmed, frame(0, 0, 64, 96),
+									 frame(64, 0, 64, 96),
+									 frame(128, 0, 64, 96)};
+	const sf::IntRect rect(16, 0, 32, 32);
+
+	frames_handle handle = NO_FRM;
+	frame_repository::create(&handle);
+	frame_repository::insert(&handle, frms.data(), frms.size(), 0,
+							 sf::IntRect(4, 8, 56, 80));
+
+	// A rectangle other than the one of the frames is applied right away.
+	CHECK(0u == frame_repository_probe::outdated(handle));
+
+	frame_repository::apply_tex_rect(&handle, rect);
+	CHECK(4u == frame_repository_probe::outdated(handle));
+
+	CHECK(frame_repository::intersect(frms[2], rect) ==
+		  frame_repository::clipped(handle, 2));
+	CHECK(3u == frame_repository_probe::outdated(handle));
+
+	// The same rectangle again outdates nothing.
+	frame_repository::apply_tex_rect(&handle, rect);
+	CHECK(3u == frame_repository_probe::outdated(handle));
+
+	frame_repository::get(handle);
+	CHECK(0u == frame_repository_probe::outdated(handle));
+
+	// Replacing with the rectangle of the frames clips the frame lazily.
+	frame_repository::replace(&handle, frms[0], 1, rect);
+	CHECK(1u == frame_repository_probe::outdated(handle));
+	CHECK(frame_repository::intersect(frms[0], rect) ==
+		  frame_repository::clipped(handle, 1));
+	CHECK(0u == frame_repository_probe::outdated(handle));
+
+	// Another rectangle is applied right away and kept, the quad follows.
+	const sf::IntRect corner(0, 0, 8, 8);
+	frame_repository::replace(&handle, frms[3], 1, corner);
+	CHECK(0u == frame_repository_probe::outdated(handle));
+	CHECK(frame_repository::intersect(frms[3], corner) ==
+		  frame_repository::clipped(handle, 1));
+	CHECK(sf::Vector2f(136.f, 8.f) ==
+		  frame_repository::quad(handle, 1).tex_coords[2]);
+
+	frame_repository::release(&handle);
+
+}
+
+TEST_CASE("generation counters reset the stamps on wraparound",
+		  "[frame_repository]") {
+
+	pool_vector<std::uint32_t> stamps;
+	stamps.push_back(0xffffffffu);
+	stamps.push_back(7);
+
+	std::uint32_t gen = 7;
+	frame_repository_probe::next_gen(&gen, &stamps);
+
+	CHECK(8u == gen);
+	CHECK(7u == stamps[1]);
+
+	// Zero is skipped, and no old stamp can match the new generation.
+	gen = 0xffffffffu;
+	frame_repository_probe::next_gen(&gen, &stamps);
+
+	CHECK(1u == gen);
+	CHECK(0u == stamps[0]);
+	CHECK(0u == stamps[1]);
+
+}
+
+TEST_CASE("animation update skips frames by their durations",
+		  "[animation]") {
+
+	animation anim;
+	anim.insert(std::vector<frame>{frame(0, 0, 10, 10), frame(10, 0, 10, 10),
+								   frame(20, 0, 10, 10)}, 0);
+
+	// 50 ms, the default of 100 ms and 200 ms, so a cycle takes 350 ms.
+	anim.durations({sf::milliseconds(50), sf::Time::Zero,
+					sf::milliseconds(200)});
+
+	// The first update starts with the first frame and ignores the time.
+	CHECK(0u == anim.update(sf::seconds(5)));
+	CHECK(sf::milliseconds(50) == anim.next_deadline());
+
+	CHECK(0u == anim.update(sf::milliseconds(49)));
+	CHECK(1u == anim.update(sf::milliseconds(1)));
+	CHECK(2u == anim.update(sf::milliseconds(120)));
+	CHECK(sf::milliseconds(180) == anim.next_deadline());
+
+	// Seven cycles and 160 ms after the start of the first frame: 10 ms into
+	// the third frame.
+	CHECK(0u == anim.update(sf::milliseconds(180)));
+	CHECK(2u == anim.update(sf::milliseconds(7 * 350 + 160)));
+	CHECK(sf::milliseconds(190) == anim.next_deadline());
+
+	// Negative times do not move the animation back.
+	CHECK(2u == anim.update(sf::milliseconds(-100)));
+	CHECK(sf::milliseconds(190) == anim.next_deadline());
+
+}
@@ -0,0 +1,97 @@
+// lz_codec_test.cpp
+
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "lz_codec.hpp"
+
+//! Pixels of an image which compresses well, with some noise.
+/*!
+* \param size Number of bytes.
+* \return Pixel data.
+*/
+static std::vector<std::uint8_t> make_pixels(std::size_t size) {
+
+	std::vector<std::uint8_t> pixels(size);
+	std::minstd_rand random(1);
+
+	for (std::size_t i = 0; i < size; ++ i) {
+
+		pixels[i] = (0 == i % 97) ? static_cast<std::uint8_t>(random()) :
+									static_cast<std::uint8_t>(i / 64);
+
+	}
+
+	return pixels;
+
+}
+
+//! Decompress and compare with the original.
+/*!
+* \param data Original data.
+* \return True if the compressed data decompresses to the original.
+*/
+static bool round_trip(const std::vector<std::uint8_t>& data) {
+
+	auto packed = lz_codec::compress(data.data(), data.size());
+	std::vector<std::uint8_t> out(data.size());
+
+	return lz_codec::decompress(packed.data(), packed.size(), out.data(),
+								out.size()) && data == out;
+
+}
+
+TEST_CASE("lz_codec restores what it compressed", "[lz_codec]") {
+
+	auto pixels = make_pixels(256 * 256 * 4);
+
+	CHECK(round_trip(pixels));
+	CHECK(lz_codec::compress(pixels.data(), pixels.size()).size() <
+		  pixels.size() / 2);
+
+	// Long runs need extra length bytes, random data only literals.
+	CHECK(round_trip(std::vector<std::uint8_t>(100000, 0)));
+
+	std::vector<std::uint8_t> noise(70000);
+	std::minstd_rand random(2);
+	for (auto& byte : noise) {
+
+		byte = static_cast<std::uint8_t>(random());
+
+	}
+
+	CHECK(round_trip(noise));
+
+	// Blocks too short to hold a match.
+	CHECK(round_trip(std::vector<std::uint8_t>()));
+	CHECK(round_trip(std::vector<std::uint8_t>{1, 2, 3}));
+
+}
+
+TEST_CASE("lz_codec rejects broken data", "[lz_codec]") {
+
+	auto pixels = make_pixels(64 * 64 * 4);
+	auto packed = lz_codec::compress(pixels.data(), pixels.size());
+	std::vector<std::uint8_t> out(pixels.size());
+
+	// Every truncation either breaks a sequence or misses bytes at the end.
+	// Only the token of the last sequence is left out, it may hold no
+	// literals.
+	for (std::size_t size = 0; size + 1 < packed.size(); ++ size) {
+
+		CHECK_FALSE(lz_codec::decompress(packed.data(), size, out.data(),
+										 out.size()));
+
+	}
+
+	// A wrong size of the uncompressed data.
+	CHECK_FALSE(lz_codec::decompress(packed.data(), packed.size(), out.data(),
+									 out.size() - 1));
+
+	// A match reaching back before the start of the data.
+	const std::uint8_t before_start[] = {0x10, 0xaa, 0x05, 0x00};
+	CHECK_FALSE(lz_codec::decompress(before_start, sizeof(before_start),
+									 out.data(), out.size()));
+
+}
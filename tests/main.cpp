@@ -0,0 +1,5 @@
+// main.cpp
+// Entry point of the tests, provided by Catch2.
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
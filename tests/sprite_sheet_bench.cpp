@@ -0,0 +1,78 @@
+// sprite_sheet_bench.cpp
+
+#include <benchmark/benchmark.h>
+#include <SFML/Graphics.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "sprite_sheet.hpp"
+
+//! Write the text form of a sheet with single frames, 100 per row.
+/*!
+* \param count Number of frames.
+* \return Path of the text form.
+*/
+static std::string write_sheet(std::size_t count) {
+
+	auto path = "wo_bench_" + std::to_string(count) + ".sheet.txt";
+	std::ofstream file(path);
+
+	for (std::size_t i = 0; i < count; ++ i) {
+
+		file << "frame " << i % 100 * 64 << " " << i / 100 * 96 <<
+				" 64 96 100\n";
+
+	}
+
+	return path;
+
+}
+
+//! Load the text form.
+static void load_text(benchmark::State& state) {
+
+	auto path = write_sheet(static_cast<std::size_t>(state.range(0)));
+	sprite_sheet sheet;
+
+	for (auto _ : state) {
+
+		if (!sheet.load_text(path)) {
+
+			state.SkipWithError("could not load the sheet");
+			break;
+
+		}
+
+	}
+
+	std::remove(path.c_str());
+
+}
+
+//! Load the binary form.
+static void load_binary(benchmark::State& state) {
+
+	auto text = write_sheet(static_cast<std::size_t>(state.range(0)));
+	auto path = text + ".bin";
+	sprite_sheet::convert(text, path);
+	std::remove(text.c_str());
+
+	sprite_sheet sheet;
+
+	for (auto _ : state) {
+
+		if (!sheet.load(path)) {
+
+			state.SkipWithError("could not load the sheet");
+			break;
+
+		}
+
+	}
+
+	std::remove(path.c_str());
+
+}
+
+BENCHMARK(load_text)->Arg(1000)->Arg(20000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(load_binary)->Arg(1000)->Arg(20000)->Unit(benchmark::kMicrosecond);
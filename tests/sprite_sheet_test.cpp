@@ -0,0 +1,90 @@
+// sprite_sheet_test.cpp
+
+#include <catch2/catch.hpp>
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "sprite_sheet.hpp"
+
+//! Write a text form into a temporary file.
+/*!
+* \param text Content of the file.
+* \return Path of the file.
+*/
+static std::string write_text(const std::string& text) {
+
+	std::string path = "wo_test_sheet.txt";
+	std::ofstream(path) << text;
+
+	return path;
+
+}
+
+TEST_CASE("sprite_sheet reads frame durations of the text form",
+		  "[sprite_sheet]") {
+
+	sprite_sheet sheet;
+	auto path = write_text("frame 0 0 10 10 850\n"
+						   "group 0 10 20 10 10 10\n");
+
+	REQUIRE(sheet.load_text(path));
+	REQUIRE(3u == sheet.durations().size());
+	CHECK(sf::milliseconds(850) == sheet.durations()[0]);
+	CHECK(sf::Time::Zero == sheet.durations()[1]);
+
+	std::remove(path.c_str());
+
+}
+
+TEST_CASE("sprite_sheet rejects durations out of range", "[sprite_sheet]") {
+
+	sprite_sheet sheet;
+
+	for (auto line : {"frame 0 0 10 10 -5\n", "frame 0 0 10 10 2147483648\n",
+					  "group 0 0 20 10 10 10 -1\n",
+					  "frame 0 0 10 10 99999999999999999999\n"}) {
+
+		auto path = write_text(line);
+
+		CHECK_FALSE(sheet.load_text(path));
+		CHECK(sheet.frames().empty());
+
+		std::remove(path.c_str());
+
+	}
+
+}
+
+TEST_CASE("sprite_sheet rejects huge frame counts", "[sprite_sheet]") {
+
+	// Header and a single group of 65535 x 65535 frames of one pixel, which
+	// matches the frame count of the header.
+	std::vector<std::uint32_t> values = {1, 1, 0, 4294836225u, 0,
+										 0, 0, 65535, 65535, 1, 1, 0};
+
+	std::string path = "wo_test_sheet.bin";
+	std::ofstream file(path, std::ios::binary);
+	file << "WOSS";
+
+	for (auto value : values) {
+
+		for (int i = 0; i < 4; ++ i) {
+
+			file.put(static_cast<char>((value >> (8 * i)) & 0xff));
+
+		}
+
+	}
+
+	file.close();
+
+	sprite_sheet sheet;
+	CHECK_FALSE(sheet.load(path));
+	CHECK(sheet.frames().empty());
+
+	std::remove(path.c_str());
+
+}
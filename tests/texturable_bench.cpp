@@ -0,0 +1,66 @@
+// texturable_bench.cpp
+
+#include <benchmark/benchmark.h>
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include "sprite.hpp"
+#include "texture_repos.hpp"
+
+//! Copy the texture, like setTexture() did before it shared textures.
+static void set_texture_copy(benchmark::State& state) {
+
+	auto size = static_cast<unsigned>(state.range(0));
+	sf::Texture texture;
+	texture.create(size, size);
+
+	for (auto _ : state) {
+
+		auto copy = std::make_shared<sf::Texture>(texture);
+		benchmark::DoNotOptimize(copy);
+
+	}
+
+}
+
+//! Share a texture held by the texture_repository.
+static void set_texture_shared(benchmark::State& state) {
+
+	auto size = static_cast<unsigned>(state.range(0));
+	sf::Image image;
+	image.create(size, size, sf::Color::White);
+
+	texture_ptr texture;
+	texture_repository::load(&texture, image);
+
+	Sprite sprite;
+
+	for (auto _ : state) {
+
+		sprite.setTexture(*texture);
+		benchmark::DoNotOptimize(sprite.getTexture());
+
+	}
+
+}
+
+//! Alias a texture which is not held by the texture_repository.
+static void set_texture_alias(benchmark::State& state) {
+
+	auto size = static_cast<unsigned>(state.range(0));
+	sf::Texture texture;
+	texture.create(size, size);
+
+	Sprite sprite;
+
+	for (auto _ : state) {
+
+		sprite.setTexture(texture);
+		benchmark::DoNotOptimize(sprite.getTexture());
+
+	}
+
+}
+
+BENCHMARK(set_texture_copy)->Arg(256)->Arg(2048);
+BENCHMARK(set_texture_shared)->Arg(256)->Arg(2048);
+BENCHMARK(set_texture_alias)->Arg(256)->Arg(2048);
@@ -0,0 +1,172 @@
+// texturable_test.cpp
+
+#include <catch2/catch.hpp>
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "sprite.hpp"
+
+//! Sprite which exposes its vertices.
+class vertex_probe : public Sprite {
+
+public :
+
+	const sf::Vertex* vertices() const {
+
+		return m_vertices;
+
+	}
+
+};
+
+//! Stream reading from a block of memory.
+class memory_stream : public sf::InputStream {
+
+public :
+
+	explicit memory_stream(const std::vector<char>& data) : m_data(data),
+															m_pos(0) {
+	}
+
+	virtual sf::Int64 read(void* data, sf::Int64 size) {
+
+		auto count = std::min(size, getSize() - m_pos);
+		std::memcpy(data, m_data.data() + m_pos,
+					static_cast<std::size_t>(count));
+		m_pos += count;
+
+		return count;
+
+	}
+
+	virtual sf::Int64 seek(sf::Int64 position) {
+
+		m_pos = std::min(position, getSize());
+
+		return m_pos;
+
+	}
+
+	virtual sf::Int64 tell() {
+
+		return m_pos;
+
+	}
+
+	virtual sf::Int64 getSize() {
+
+		return static_cast<sf::Int64>(m_data.size());
+
+	}
+
+private :
+
+	const std::vector<char>& m_data;
+	sf::Int64 m_pos;
+
+};
+
+TEST_CASE("setTexture drops the area of a previous view", "[texturable]") {
+
+	sf::Image image;
+	image.create(64, 64, sf::Color::White);
+
+	vertex_probe sprite;
+
+	// An area which is not scaled is loaded as view at an offset of the
+	// whole image.
+	REQUIRE(sprite.load(image, sf::IntRect(), sf::IntRect(16, 16, 32, 32)));
+	REQUIRE(sf::Vector2f(16.f, 16.f) == sprite.vertices()[0].texCoords);
+
+	// Same rectangle on a texture of its own.
+	sf::Texture texture;
+	REQUIRE(texture.create(32, 32));
+	sprite.setTexture(texture);
+
+	CHECK(sf::IntRect(0, 0, 32, 32) == sprite.getTexRect());
+	CHECK(sf::Vector2f(0.f, 0.f) == sprite.vertices()[0].texCoords);
+	CHECK(sf::Vector2f(32.f, 32.f) == sprite.vertices()[2].texCoords);
+
+}
+
+TEST_CASE("Loading an evicted texture keeps its size", "[texturable]") {
+
+	sf::Image evicted;
+	evicted.create(64, 32, sf::Color::White);
+	sf::Image recent;
+	recent.create(16, 16, sf::Color::Black);
+
+	vertex_probe first;
+	REQUIRE(first.load(evicted));
+	vertex_probe second;
+	REQUIRE(second.load(recent));
+
+	// Only the most recently used texture stays resident.
+	texture_repository::budget(1);
+	REQUIRE(0u == first.getTexture()->getSize().x);
+
+	// Served by the cache while still evicted.
+	vertex_probe sprite;
+	REQUIRE(sprite.load(evicted));
+	CHECK(sf::IntRect(0, 0, 64, 32) == sprite.getTexRect());
+	CHECK(sf::Vector2f(64.f, 32.f) == sprite.vertices()[2].position);
+
+	vertex_probe view;
+	REQUIRE(view.load(evicted, sf::IntRect(), sf::IntRect(48, 16, 32, 32)));
+	CHECK(sf::IntRect(0, 0, 16, 16) == view.getTexRect());
+	CHECK(sf::Vector2f(48.f, 16.f) == view.vertices()[0].texCoords);
+	CHECK(sf::Vector2f(64.f, 32.f) == view.vertices()[2].texCoords);
+
+	texture_repository::budget(0);
+
+}
+
+TEST_CASE("Loading from a stream drops the area of a previous view",
+		  "[texturable]") {
+
+	sf::Image image;
+	image.create(64, 64, sf::Color::White);
+
+	vertex_probe sprite;
+	REQUIRE(sprite.load(image, sf::IntRect(), sf::IntRect(16, 16, 32, 32)));
+	REQUIRE(sf::Vector2f(16.f, 16.f) == sprite.vertices()[0].texCoords);
+
+	// An image of the same size as the view, so the rectangle stays the same.
+	sf::Image part;
+	part.create(32, 32, sf::Color::Black);
+	REQUIRE(part.saveToFile("wo_test_stream.png"));
+
+	std::ifstream file("wo_test_stream.png", std::ios::binary);
+	std::vector<char> data((std::istreambuf_iterator<char>(file)),
+						   std::istreambuf_iterator<char>());
+	file.close();
+	std::remove("wo_test_stream.png");
+
+	memory_stream stream(data);
+	REQUIRE(sprite.load(stream));
+
+	CHECK(sf::IntRect(0, 0, 32, 32) == sprite.getTexRect());
+	CHECK(sf::Vector2f(0.f, 0.f) == sprite.vertices()[0].texCoords);
+	CHECK(sf::Vector2f(32.f, 32.f) == sprite.vertices()[2].texCoords);
+
+}
+
+TEST_CASE("setTexture with a null pointer removes the texture",
+		  "[texturable]") {
+
+	sf::Image image;
+	image.create(32, 32, sf::Color::White);
+
+	vertex_probe sprite;
+	REQUIRE(sprite.load(image));
+
+	sprite.setTexture(texture_ptr(), true);
+
+	CHECK(nullptr == sprite.getTexture());
+	CHECK(sf::IntRect(0, 0, 32, 32) == sprite.getTexRect());
+
+}
@@ -0,0 +1,82 @@
+// texture_load_bench.cpp
+
+#include <benchmark/benchmark.h>
+#include <SFML/Graphics.hpp>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "texture_repos.hpp"
+
+//! Write a noisy square image, so the file does not compress to nothing.
+/*!
+* \param size Width and height of the image.
+* \return Path of the written file, empty on failure.
+*/
+static std::string write_image(unsigned size) {
+
+	std::vector<sf::Uint8> pixels(size * size * 4);
+	unsigned seed = 1;
+
+	for (auto& channel : pixels) {
+
+		seed = seed * 1103515245 + 12345;
+		channel = static_cast<sf::Uint8>(seed >> 16);
+
+	}
+
+	sf::Image image;
+	image.create(size, size, pixels.data());
+
+	auto path = "wo_bench_" + std::to_string(size) + ".png";
+
+	return image.saveToFile(path) ? path : std::string();
+
+}
+
+//! Load and release an image file with texture_repository::load().
+static void load_buffered(benchmark::State& state) {
+
+	auto path = write_image(static_cast<unsigned>(state.range(0)));
+
+	for (auto _ : state) {
+
+		// Released at the end of the iteration, so every load decodes.
+		texture_ptr tex;
+
+		if (!texture_repository::load(&tex, path)) {
+
+			state.SkipWithError("could not load the image");
+			break;
+
+		}
+
+	}
+
+	std::remove(path.c_str());
+
+}
+
+//! Load and release an image file with texture_repository::load_mapped().
+static void load_mapped(benchmark::State& state) {
+
+	auto path = write_image(static_cast<unsigned>(state.range(0)));
+
+	for (auto _ : state) {
+
+		texture_ptr tex;
+
+		if (!texture_repository::load_mapped(&tex, path)) {
+
+			state.SkipWithError("could not load the image");
+			break;
+
+		}
+
+	}
+
+	std::remove(path.c_str());
+
+}
+
+BENCHMARK(load_buffered)->Arg(256)->Arg(2048)->Unit(benchmark::kMillisecond);
+BENCHMARK(load_mapped)->Arg(256)->Arg(2048)->Unit(benchmark::kMillisecond);
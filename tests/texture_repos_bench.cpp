@@ -0,0 +1,98 @@
+// texture_repos_bench.cpp
+
+#include <benchmark/benchmark.h>
+#include <SFML/Graphics.hpp>
+#include <random>
+#include <vector>
+#include "texture_repos.hpp"
+
+//! Number of sources the threads pick from.
+static const std::size_t sources = 64;
+
+//! Create the images the benchmarks load, each with its own key.
+static std::vector<sf::Image> make_images() {
+
+	std::vector<sf::Image> result(sources);
+
+	for (std::size_t i = 0; i < sources; ++ i) {
+
+		result[i].create(32, 32, sf::Color(static_cast<sf::Uint8>(i), 0, 0));
+
+	}
+
+	return result;
+
+}
+
+//! Images the benchmarks load, created by the first thread asking for them.
+static const std::vector<sf::Image>& images() {
+
+	static const std::vector<sf::Image> result = make_images();
+
+	return result;
+
+}
+
+//! Textures kept alive by load_hit, so every load is served by the cache.
+static std::vector<texture_ptr> held;
+
+//! Load textures which are alive, from several threads at once.
+static void load_hit(benchmark::State& state) {
+
+	if (0 == state.thread_index()) {
+
+		held.resize(sources);
+
+		for (std::size_t i = 0; i < sources; ++ i) {
+
+			texture_repository::load(&held[i], images()[i]);
+
+		}
+
+	}
+
+	std::minstd_rand random(static_cast<unsigned>(state.thread_index() + 1));
+
+	for (auto _ : state) {
+
+		texture_ptr tex;
+		texture_repository::load(&tex, images()[random() % sources]);
+		benchmark::DoNotOptimize(tex);
+
+	}
+
+	state.SetItemsProcessed(state.iterations());
+
+	if (0 == state.thread_index()) {
+
+		held.clear();
+
+	}
+
+}
+
+//! Load and release textures, from several threads at once.
+/*!
+* Nothing keeps the textures alive, so most loads upload the image and every
+* release removes the texture from its shard again.
+*/
+static void load_release(benchmark::State& state) {
+
+	images();
+
+	std::minstd_rand random(static_cast<unsigned>(state.thread_index() + 1));
+
+	for (auto _ : state) {
+
+		texture_ptr tex;
+		texture_repository::load(&tex, images()[random() % sources]);
+		benchmark::DoNotOptimize(tex);
+
+	}
+
+	state.SetItemsProcessed(state.iterations());
+
+}
+
+BENCHMARK(load_hit)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(load_release)->ThreadRange(1, 16)->UseRealTime();
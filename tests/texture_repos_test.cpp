@@ -0,0 +1,259 @@
+// texture_repos_test.cpp
+
+#include <catch2/catch.hpp>
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+#include <vector>
+#include "texture_repos.hpp"
+#include "sprite.hpp"
+
+//! Create images which differ in their pixels, so each gets its own key.
+/*!
+* \param count Number of images.
+* \param size Width and height of each image.
+* \return Images.
+*/
+static std::vector<sf::Image> make_images(std::size_t count, unsigned size) {
+
+	std::vector<sf::Image> images(count);
+
+	for (std::size_t i = 0; i < count; ++ i) {
+
+		images[i].create(size, size,
+						 sf::Color(static_cast<sf::Uint8>(i), 0, 0));
+
+	}
+
+	return images;
+
+}
+
+//! Check that the counters of the repository match its textures.
+static void check_consistency() {
+
+	auto stats = texture_repository::stats();
+	std::size_t resident_bytes = 0;
+
+	for (auto& source : stats.sources) {
+
+		CHECK(0 < source.refs);
+		resident_bytes += source.resident ? source.bytes : 0;
+
+	}
+
+	CHECK(stats.sources.size() == texture_repository::live());
+	CHECK(resident_bytes == texture_repository::bytes());
+
+}
+
+TEST_CASE("texture_repository stays consistent under concurrent loads",
+		  "[texture_repository]") {
+
+	REQUIRE(0u == texture_repository::live());
+
+	const std::size_t sources = 32;
+	const unsigned size = 64;
+	const std::size_t tex_bytes = size * size * 4;
+	const std::size_t iterations = 2000;
+	const std::size_t threads =
+		std::max<std::size_t>(4, std::thread::hardware_concurrency());
+
+	auto images = make_images(sources, size);
+
+	// Room for a quarter of the sources, so the render thread keeps evicting
+	// and restoring while the loaders run.
+	texture_repository::budget(sources / 4 * tex_bytes);
+
+	// Textures published by the loaders for the render thread to touch.
+	std::vector<texture_ptr> board(sources);
+	std::mutex board_mutex;
+
+	std::atomic<std::size_t> failures(0);
+	std::atomic<std::size_t> wrong_sizes(0);
+	std::atomic<std::size_t> running(threads);
+	std::vector<std::thread> loaders;
+
+	for (std::size_t t = 0; t < threads; ++ t) {
+
+		loaders.emplace_back([&, t]() {
+
+			std::minstd_rand random(static_cast<unsigned>(t + 1));
+
+			// Keeps the last few textures alive, so the older ones are
+			// released on this thread while others may still use them.
+			std::vector<texture_ptr> held(4);
+
+			for (std::size_t i = 0; i < iterations; ++ i) {
+
+				auto source = random() % sources;
+				texture_ptr tex;
+
+				// Views and sprites size themselves while the render thread
+				// may evict the very same texture.
+				if (0 == i % 16) {
+
+					Sprite sprite;
+					if (!sprite.load(images[source])) {
+
+						++ failures;
+						continue;
+
+					}
+
+					if (sf::IntRect(0, 0, size, size) != sprite.getTexRect()) {
+
+						++ wrong_sizes;
+
+					}
+
+				}
+
+				sf::IntRect rect;
+				if (!texture_repository::load_view(&tex, &rect, images[source],
+												   sf::IntRect(size / 2, 0,
+															   size, size))) {
+
+					++ failures;
+					continue;
+
+				}
+
+				if (sf::IntRect(size / 2, 0, size / 2, size) != rect) {
+
+					++ wrong_sizes;
+
+				}
+
+				if (0 == i % 8) {
+
+					std::lock_guard<std::mutex> lock(board_mutex);
+					board[source] = tex;
+
+				}
+
+				held[i % held.size()] = std::move(tex);
+
+			}
+
+			-- running;
+
+		});
+
+	}
+
+	// The test thread is the render thread, the only one allowed to touch.
+	std::minstd_rand random(0);
+	while (0 < running) {
+
+		texture_ptr tex;
+
+		{
+
+			std::lock_guard<std::mutex> lock(board_mutex);
+			tex = board[random() % sources];
+
+		}
+
+		if (nullptr != tex) {
+
+			texture_repository::touch(tex);
+
+		}
+
+	}
+
+	for (auto& loader : loaders) {
+
+		loader.join();
+
+	}
+
+	REQUIRE(0u == failures.load());
+	CHECK(0u == wrong_sizes.load());
+	CHECK(0u < texture_repository::stats().evictions);
+
+	// Only the board holds textures now, each source at most once.
+	std::set<const sf::Texture*> distinct;
+	for (auto& tex : board) {
+
+		if (nullptr != tex) {
+
+			distinct.insert(tex.get());
+
+		}
+
+	}
+
+	CHECK(distinct.size() == texture_repository::live());
+	check_consistency();
+
+	// Setting the budget again evicts down to it.
+	texture_repository::budget(sources / 4 * tex_bytes);
+	CHECK(texture_repository::bytes() <= texture_repository::budget());
+	check_consistency();
+
+	board.clear();
+	texture_repository::budget(0);
+
+	CHECK(0u == texture_repository::live());
+	CHECK(0u == texture_repository::bytes());
+	CHECK(0u == texture_repository::tier_bytes());
+
+}
+
+TEST_CASE("Scaled areas are clipped to the image", "[texture_repository]") {
+
+	auto images = make_images(1, 64);
+
+	// Area reaching beyond the image, scaled (which crops on the CPU) and not
+	// scaled (which lets the texture clip it).
+	texture_ptr scaled;
+	REQUIRE(texture_repository::load(&scaled, images[0],
+									 sf::IntRect(32, 48, 64, 64),
+									 sf::Vector2u(64, 64)));
+	texture_ptr plain;
+	REQUIRE(texture_repository::load(&plain, images[0],
+									 sf::IntRect(32, 48, 64, 64)));
+
+	CHECK(sf::Vector2u(32, 16) == texture_repository::size(scaled));
+	CHECK(texture_repository::size(plain) == texture_repository::size(scaled));
+
+}
+
+// Runs last, since the pages of the atlas live until the end of the program.
+TEST_CASE("Atlas pages are counted and never evicted",
+		  "[texture_repository]") {
+
+	auto images = make_images(1, 16);
+	auto bytes = texture_repository::bytes();
+
+	texture_ptr page;
+	sf::IntRect rect;
+	REQUIRE(texture_repository::load_atlas(&page, &rect, "wo_test_atlas.png",
+										   images[0]));
+
+	auto page_size = texture_repository::size(page);
+	auto page_bytes = static_cast<std::size_t>(page_size.x) * page_size.y * 4;
+	CHECK(bytes + page_bytes == texture_repository::bytes());
+
+	auto sources = texture_repository::stats().sources;
+	CHECK(sources.end() != std::find_if(sources.begin(), sources.end(),
+		[page_bytes](const texture_repository::source_stats& source) {
+
+			return 0 == source.source.find("atlas:") &&
+				   page_bytes == source.bytes && source.resident;
+
+		}));
+
+	texture_repository::budget(1);
+	CHECK(page_size == page->getSize());
+	texture_repository::budget(0);
+
+	check_consistency();
+
+}
@@ -0,0 +1,67 @@
+// worker_pool_test.cpp
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+#include "worker_pool.hpp"
+
+TEST_CASE("worker_pool runs queued tasks before it is destroyed",
+		  "[worker_pool]") {
+
+	std::vector<std::future<int>> results;
+
+	{
+
+		worker_pool pool(1);
+
+		// Keep the only thread busy, so the other tasks are still queued when
+		// the pool is destroyed.
+		pool.push([]() {
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+		});
+
+		for (int i = 0; i < 100; ++ i) {
+
+			results.push_back(pool.submit([i]() { return i; }));
+
+		}
+
+	}
+
+	for (int i = 0; i < 100; ++ i) {
+
+		REQUIRE(i == results[i].get());
+
+	}
+
+}
+
+TEST_CASE("worker_pool with one thread runs tasks in order", "[worker_pool]") {
+
+	std::vector<int> order;
+
+	{
+
+		worker_pool pool(1);
+
+		for (int i = 0; i < 10; ++ i) {
+
+			pool.push([i, &order]() { order.push_back(i); });
+
+		}
+
+	}
+
+	REQUIRE(10u == order.size());
+
+	for (int i = 0; i < 10; ++ i) {
+
+		CHECK(i == order[i]);
+
+	}
+
+}